@@ -4,6 +4,10 @@
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef __cplusplus
+#include <type_traits>
+#endif
+
 /* ------------------------------------------------------------------------- */
 /* partial-evaluation async requests and queues                              */
 /* ------------------------------------------------------------------------- */
@@ -34,17 +38,96 @@ struct weval_req_t {
   uint8_t* argbuf;
   uint32_t arglen;
   weval_func_t* specialized;
+  uint32_t flags; /* `WEVAL_REQ_FLAG_*` bits. */
+  /* Relative importance of this request: the weval tool specializes
+   * in descending priority order, and when invoked with a
+   * specialization budget (`--max-specializations`), the
+   * lowest-priority requests are left unprocessed -- their call sites
+   * fall back to the generic function. */
+  uint32_t priority;
+  /* Optional stable identity of this request, or 0 if absent. Only
+   * meaningful when `WEVAL_REQ_FLAG_CONTENT_HASH` is set in `flags`.
+   * Set via weval::set_content_hash(): a hash over `user_id`, the
+   * argbuf bytes, and a caller-supplied salt -- deliberately
+   * excluding the function-table index in `func`, which shifts across
+   * relinks. The weval tool's cache keys on this when present, so
+   * byte-identical requests skip respecialization even when their
+   * argbufs embed differing heap addresses. */
+  uint64_t content_hash;
 };
 
+/* The request record and argbuf were carved out of a
+ * `weval_req_arena_t` rather than malloc'd individually; `weval_free`
+ * must not free them (the arena is bulk-freed instead). */
+#define WEVAL_REQ_FLAG_ARENA 1
+
+/* The request's argbuf uses the packed (v2) argument encoding -- one
+ * tag byte per argument, 4-byte slots for i32/f32, ULEB128 buffer
+ * lengths, no alignment padding -- rather than the legacy array of
+ * 16-byte `weval_req_arg_t` records. The weval tool understands both
+ * encodings; guests opt in at compile time by defining
+ * `WEVAL_PACKED_ARGS=1` before including this header. With tens of
+ * thousands of requests the argbufs are a few MB of mostly-zero
+ * snapshot data under the legacy encoding; the packed form shrinks
+ * them several-fold. */
+#define WEVAL_REQ_FLAG_ARGS_V2 2
+
+/* The `content_hash` field is present and was stamped by
+ * weval::set_content_hash(). Guests built against an older header
+ * allocate a shorter record, so the weval tool must not interpret
+ * bytes past the fields the guest knows about; this bit (together
+ * with a validity check on the flags word as a whole) gates the
+ * tool's read of `content_hash`. */
+#define WEVAL_REQ_FLAG_CONTENT_HASH 4
+
+#ifndef WEVAL_PACKED_ARGS
+#define WEVAL_PACKED_ARGS 0
+#endif
+
+/* On memory64 (wasm64) targets, pointers and buffer lengths no longer
+ * fit the fixed 32-bit fields of the legacy `weval_req_arg_t` record,
+ * so the packed encoding -- whose pointer/length fields are ULEB128
+ * and whose pointer args are encoded as i64 scalars -- is required.
+ * (Note that tool-side support for loading wasm64 snapshots is still
+ * pending; this defines the guest-side encoding so wasm64 modules can
+ * register requests.) */
+#if defined(__wasm64__) && !WEVAL_PACKED_ARGS
+#error "wasm64 requires the packed argument encoding; define WEVAL_PACKED_ARGS=1"
+#endif
+
 typedef enum {
   weval_req_arg_i32 = 0,
   weval_req_arg_i64 = 1,
   weval_req_arg_f32 = 2,
   weval_req_arg_f64 = 3,
   weval_req_arg_buffer = 4,
+  /* Like `weval_req_arg_buffer`, but the constant bytes are *not*
+   * copied into the argbuf: the arg carries a pointer into the live
+   * (snapshotted) heap and the weval tool reads the contents from
+   * there. The buffer must not be mutated between registration and
+   * the snapshot. */
+  weval_req_arg_buffer_ref = 5,
+  /* A sequence of by-reference buffer segments (an array of
+   * `weval_buffer_seg_t`) that the weval tool logically concatenates
+   * into one constant buffer. Lets multi-megabyte constant memory --
+   * larger than the argbuf ceiling, or not contiguous in the heap --
+   * be specialized on without one giant contiguous copy. As with
+   * `weval_req_arg_buffer_ref`, neither the segment array nor the
+   * segment contents may be mutated between registration and the
+   * snapshot. */
+  weval_req_arg_buffer_chunked = 6,
   weval_req_arg_none = 255,
 } weval_req_arg_type;
 
+/* One segment of a chunked buffer arg. In the legacy (v1) encoding
+ * the weval tool reads this layout directly out of the snapshotted
+ * heap, so it is fixed at two 32-bit fields; v1 is wasm32-only (see
+ * the wasm64 guard above), so the pointer-sized fields match. */
+typedef struct weval_buffer_seg_t {
+  uintptr_t ptr;
+  size_t len;
+} weval_buffer_seg_t;
+
 struct weval_req_arg_t {
   uint32_t specialize; /* is this argument specialized? */
   uint32_t
@@ -63,11 +146,73 @@ struct weval_req_arg_t {
       /* Size of buffer in data stream; next arg follows inline data. */
       uint32_t padded_len;
     } buffer;
+    struct {
+      /* A pointer to constant memory in the live heap; no data
+       * follows inline. */
+      uint32_t ptr;
+      uint32_t len;
+    } buffer_ref;
+    struct {
+      /* A pointer to an array of `count` `weval_buffer_seg_t` records
+       * in the live heap; no data follows inline. */
+      uint32_t segs;
+      uint32_t count;
+    } buffer_chunks;
   } u;
 };
 
+/*
+ * An alternative, contiguous representation of pending requests: a
+ * growable array of by-value `weval_req_t` records. The linked list
+ * rooted at `weval_req_pending_head` scatters records across the
+ * malloc heap, and with tens of thousands of requests the host tool's
+ * collection phase becomes a pointer-chase over cold memory; the
+ * table makes both guest-side registration and host-side scanning
+ * sequential passes. The two representations coexist: the weval tool
+ * processes the linked list first, then the table.
+ *
+ * Layout (entries pointer, length, capacity -- 32-bit words on
+ * wasm32) and the record stride are hardcoded in `src/directive.rs`;
+ * please keep both in sync.
+ */
+typedef struct weval_req_table_t {
+  weval_req_t* entries;
+  size_t len;
+  size_t cap;
+} weval_req_table_t;
+
+/*
+ * Request-queue statistics, readable by the guest. The first group of
+ * counters is accumulated by `weval_request()`/`weval_free()` as
+ * requests come and go, so init code can log queue size and argbuf
+ * footprint before the snapshot; the second group is filled in by the
+ * weval tool when it processes the snapshot, so post-weval runtime
+ * code can compare satisfied against processed and alert when the
+ * ratio drops (a lost specialization otherwise only shows up as a
+ * latency regression). Field offsets are hardcoded in `src/eval.rs`;
+ * please keep both in sync.
+ */
+typedef struct weval_stats_t {
+  /* Accumulated by the guest: */
+  uint64_t requests_registered;
+  /* Requests discarded because the module was already wevaled and
+   * re-weval was not enabled. */
+  uint64_t requests_dropped;
+  uint64_t argbuf_bytes;
+  uint64_t requests_freed;
+  /* Filled in by the weval tool: total directives it decoded, and how
+   * many produced a specialized function (including cache hits).
+   * Requests past a `--max-specializations` budget, and requests
+   * whose specialization failed, are processed but not satisfied. */
+  uint64_t requests_processed;
+  uint64_t requests_satisfied;
+} weval_stats_t;
+
 extern weval_req_t* weval_req_pending_head;
+extern weval_req_table_t weval_req_pending_table;
 extern bool weval_is_wevaled;
+extern bool weval_reweval_enabled;
+extern weval_stats_t weval_stats;
 
 #define WEVAL_DEFINE_GLOBALS()                                          \
   weval_req_t* weval_req_pending_head;                                  \
@@ -76,11 +221,25 @@ extern bool weval_is_wevaled;
     return &weval_req_pending_head;                                     \
   }                                                                     \
                                                                         \
+  weval_req_table_t weval_req_pending_table;                            \
+  __attribute__((export_name("weval.pending.table"))) weval_req_table_t* \
+  __weval_pending_table() {                                             \
+    return &weval_req_pending_table;                                    \
+  }                                                                     \
+                                                                        \
   bool weval_is_wevaled;                                                \
   __attribute__((export_name("weval.is.wevaled"))) bool*                \
   __weval_is_wevaled() {                                                \
     return &weval_is_wevaled;                                           \
-  }
+  }                                                                     \
+                                                                        \
+  weval_stats_t weval_stats;                                            \
+  __attribute__((export_name("weval.stats"))) weval_stats_t*            \
+  __weval_stats() {                                                     \
+    return &weval_stats;                                                \
+  }                                                                     \
+                                                                        \
+  bool weval_reweval_enabled;
 
 #define WEVAL_DEFINE_TARGET(index, func)             \
   __attribute__((export_name("weval.func." #index))) \
@@ -88,20 +247,158 @@ extern bool weval_is_wevaled;
     return (weval_func_t) & (func);                  \
   }
 
+/*
+ * A single-export alternative to `WEVAL_DEFINE_TARGET()`: a table
+ * mapping indices to specializable-function pointers.
+ *
+ * `WEVAL_DEFINE_TARGET()` emits one named export per target, which is
+ * fine for a handful of targets but bloats the export section (and
+ * every tool pass that scans it) when there are hundreds, and forces
+ * the targets to be enumerated one macro invocation at a time. The
+ * table form emits a single `weval.func.table` export -- an accessor
+ * returning a (entries, len) pair, in the style of
+ * `weval.pending.table` -- so that looking up target `i` is one
+ * indexed read rather than an export-name string match.
+ *
+ * Invoke the macro once, listing the targets in index order (indices
+ * are positional, starting at 0):
+ *
+ *     WEVAL_DEFINE_TARGET_TABLE(
+ *         WEVAL_TARGET_ENTRY(Interpret<true>),
+ *         WEVAL_TARGET_ENTRY(InterpretBaseline));
+ *
+ * Referencing each function in the table takes its address, which
+ * pins it in the indirect function table exactly as
+ * `WEVAL_DEFINE_TARGET()` does. The two forms coexist; modules with
+ * few targets can keep using per-target exports.
+ */
+typedef struct weval_target_table_t {
+  weval_func_t* entries;
+  size_t len;
+} weval_target_table_t;
+
+#define WEVAL_TARGET_ENTRY(func) ((weval_func_t) & (func))
+
+#define WEVAL_DEFINE_TARGET_TABLE(...)                                   \
+  static weval_func_t __weval_target_entries[] = {__VA_ARGS__};          \
+  static weval_target_table_t __weval_target_table = {                   \
+      __weval_target_entries,                                            \
+      sizeof(__weval_target_entries) / sizeof(weval_func_t)};            \
+  __attribute__((export_name("weval.func.table"))) weval_target_table_t* \
+  __weval_func_table() {                                                 \
+    return &__weval_target_table;                                        \
+  }
+
+/*
+ * Re-weval mode: incremental specialization of a wevaled module.
+ *
+ * By default, requests registered after the module has been wevaled
+ * (`weval_is_wevaled` set) are dropped -- anything learned at runtime
+ * (newly loaded scripts, say) can never be specialized. Calling
+ * `weval_enable_reweval()` makes post-snapshot registration enqueue
+ * requests as usual, enabling an incremental flow:
+ *
+ *  1. weval the module as usual; the tool unlinks every request it
+ *     processes from the pending list (and zeroes the pending table's
+ *     length), so a wevaled module starts with an empty queue.
+ *  2. At runtime, enable re-weval and register requests for newly
+ *     loaded code; they accumulate on the (now-empty) pending list.
+ *  3. Snapshot the running instance again and run weval over the new
+ *     snapshot. Only the newly accumulated requests are seen, so only
+ *     the new specialized functions are appended and only their
+ *     destinations written -- a small incremental pass instead of a
+ *     full one.
+ *
+ * Caveat: the weval tool's post-filter pass replaces the "weval"
+ * intrinsic imports with no-op polyfills, so in re-weval passes the
+ * context/stack intrinsics no longer steer specialization; requests
+ * registered post-snapshot get plain constant propagation on their
+ * arguments. Run the flow against the unfiltered module if full
+ * intrinsic-directed specialization is needed.
+ */
+static inline void weval_enable_reweval() { weval_reweval_enabled = true; }
+
+/* Bumps a `weval_stats_t` counter; atomic under threads so that
+ * parallel registrars (see `weval_request()`) do not lose counts. */
+static inline void weval_stats_add(uint64_t* counter, uint64_t n) {
+#if defined(__wasm_atomics__)
+  __atomic_fetch_add(counter, n, __ATOMIC_RELAXED);
+#else
+  *counter += n;
+#endif
+}
+
 static inline void weval_request(weval_req_t* req) {
-  if (weval_is_wevaled) {
-      /* nothing! */
-  } else {
-    req->next = weval_req_pending_head;
-    req->prev = NULL;
-    if (weval_req_pending_head) {
-      weval_req_pending_head->prev = req;
+  if (weval_is_wevaled && !weval_reweval_enabled) {
+    weval_stats_add(&weval_stats.requests_dropped, 1);
+    return;
+  }
+  weval_stats_add(&weval_stats.requests_registered, 1);
+  weval_stats_add(&weval_stats.argbuf_bytes, req->arglen);
+#if defined(__wasm_atomics__)
+  /* When built with threads, registration is a lock-free push so that
+   * parallel init workers can enqueue requests concurrently. The head
+   * is claimed by CAS; the displaced head's `prev` is then written by
+   * the (single) pusher that displaced it, so no two threads write
+   * the same field. Only *registration* is concurrent-safe:
+   * unlinking (`weval_free()`, and the weval tool's collection over a
+   * snapshot) must be quiesced relative to pushes, which snapshotting
+   * guarantees anyway. */
+  req->prev = NULL;
+  weval_req_t* head = __atomic_load_n(&weval_req_pending_head, __ATOMIC_RELAXED);
+  do {
+    req->next = head;
+  } while (!__atomic_compare_exchange_n(&weval_req_pending_head, &head, req,
+                                        /* weak = */ true, __ATOMIC_RELEASE,
+                                        __ATOMIC_RELAXED));
+  if (head) {
+    __atomic_store_n(&head->prev, req, __ATOMIC_RELAXED);
+  }
+#else
+  req->next = weval_req_pending_head;
+  req->prev = NULL;
+  if (weval_req_pending_head) {
+    weval_req_pending_head->prev = req;
+  }
+  weval_req_pending_head = req;
+#endif
+}
+
+/* Append `*req` by value to the pending table instead of linking it
+ * onto the pending list. The record itself is copied, so a
+ * stack-allocated `weval_req_t` works; the argbuf is not copied and
+ * must stay live (and unmutated) until the snapshot. Returns false on
+ * allocation failure. Unlike `weval_request()`, the table append is
+ * *not* thread-safe (it reallocs a shared array); parallel
+ * registrars should use the pending list. */
+static inline bool weval_request_into_table(const weval_req_t* req) {
+  if (weval_is_wevaled && !weval_reweval_enabled) {
+    weval_stats_add(&weval_stats.requests_dropped, 1);
+    return true;
+  }
+  weval_req_table_t* table = &weval_req_pending_table;
+  if (table->len == table->cap) {
+    size_t new_cap = table->cap ? table->cap * 2 : 64;
+    weval_req_t* entries = (weval_req_t*)realloc(
+        table->entries, new_cap * sizeof(weval_req_t));
+    if (!entries) {
+      return false;
     }
-    weval_req_pending_head = req;
+    table->entries = entries;
+    table->cap = new_cap;
   }
+  weval_req_t* slot = &table->entries[table->len++];
+  *slot = *req;
+  /* Table entries are not on the linked list. */
+  slot->next = NULL;
+  slot->prev = NULL;
+  weval_stats_add(&weval_stats.requests_registered, 1);
+  weval_stats_add(&weval_stats.argbuf_bytes, req->arglen);
+  return true;
 }
 
 static inline void weval_free(weval_req_t* req) {
+  weval_stats_add(&weval_stats.requests_freed, 1);
   if (req->prev) {
     req->prev->next = req->next;
   } else if (weval_req_pending_head == req) {
@@ -110,12 +407,95 @@ static inline void weval_free(weval_req_t* req) {
   if (req->next) {
     req->next->prev = req->prev;
   }
+  if (req->flags & WEVAL_REQ_FLAG_ARENA) {
+    /* Storage is owned by the arena; freed in bulk by
+     * `weval_arena_free()`. */
+    return;
+  }
   if (req->argbuf) {
     free(req->argbuf);
   }
   free(req);
 }
 
+/* ------------------------------------------------------------------------- */
+/* arena allocation for requests                                             */
+/* ------------------------------------------------------------------------- */
+
+/*
+ * A simple slab arena for request records and argument buffers.
+ *
+ * Embedders that register very many requests during pre-init (one per
+ * compiled function, say) pay one malloc for the `weval_req_t` and at
+ * least one more for its argbuf; across tens of thousands of requests
+ * the allocator traffic and resulting heap fragmentation inflate both
+ * init time and the snapshotted heap image. An arena instead carves
+ * records and argbufs out of large contiguous chunks with a bump
+ * pointer, and the whole set is released with a single
+ * `weval_arena_free()`.
+ *
+ * Requests allocated from an arena are marked with
+ * `WEVAL_REQ_FLAG_ARENA` so that `weval_free()` only unlinks them; do
+ * not free an arena while any of its requests are still on the
+ * pending list.
+ */
+
+typedef struct weval_req_arena_chunk_t weval_req_arena_chunk_t;
+struct weval_req_arena_chunk_t {
+  weval_req_arena_chunk_t* next;
+  size_t len;
+  size_t cap;
+  /* Chunk data follows the header. */
+};
+
+typedef struct weval_req_arena_t {
+  weval_req_arena_chunk_t* chunks;
+  size_t chunk_size;
+} weval_req_arena_t;
+
+#define WEVAL_ARENA_DEFAULT_CHUNK_SIZE (1024 * 1024)
+
+static inline void weval_arena_init(weval_req_arena_t* arena,
+                                    size_t chunk_size) {
+  arena->chunks = NULL;
+  arena->chunk_size = chunk_size ? chunk_size : WEVAL_ARENA_DEFAULT_CHUNK_SIZE;
+}
+
+static inline void* weval_arena_alloc(weval_req_arena_t* arena, size_t bytes) {
+  /* Keep all carved-out allocations 8-byte-aligned. */
+  bytes = (bytes + 7) & ~(size_t)7;
+  weval_req_arena_chunk_t* chunk = arena->chunks;
+  if (!chunk || chunk->len + bytes > chunk->cap) {
+    size_t cap = arena->chunk_size;
+    if (cap < bytes) {
+      cap = bytes;
+    }
+    chunk = (weval_req_arena_chunk_t*)malloc(sizeof(weval_req_arena_chunk_t) +
+                                             cap);
+    if (!chunk) {
+      return NULL;
+    }
+    chunk->next = arena->chunks;
+    chunk->len = 0;
+    chunk->cap = cap;
+    arena->chunks = chunk;
+  }
+  uint8_t* data = (uint8_t*)(chunk + 1);
+  void* ret = data + chunk->len;
+  chunk->len += bytes;
+  return ret;
+}
+
+static inline void weval_arena_free(weval_req_arena_t* arena) {
+  weval_req_arena_chunk_t* chunk = arena->chunks;
+  while (chunk) {
+    weval_req_arena_chunk_t* next = chunk->next;
+    free(chunk);
+    chunk = next;
+  }
+  arena->chunks = NULL;
+}
+
 /* ------------------------------------------------------------------------- */
 /* intrinsics                                                                */
 /* ------------------------------------------------------------------------- */
@@ -136,10 +516,97 @@ void weval_update_context(uint32_t pc) WEVAL_WASM_IMPORT("update.context");
 uint64_t weval_read_reg(uint64_t idx) WEVAL_WASM_IMPORT("read.reg");
 void weval_write_reg(uint64_t idx, uint64_t value)
     WEVAL_WASM_IMPORT("write.reg");
+/* Bulk register-window forms: move registers [base, base+count) to or
+ * from a contiguous 8-byte-stride region with a single intrinsic
+ * call. Opcodes that touch many virtual registers at once (call
+ * setup, frame spill) pay one call instead of one per register, and
+ * the specializer expands the window inline. `count` must be a
+ * specialization-time constant. */
+void weval_read_regs(uint64_t base, uint32_t count, uint64_t* out)
+    WEVAL_WASM_IMPORT("read.regs");
+void weval_write_regs(uint64_t base, uint32_t count, const uint64_t* in)
+    WEVAL_WASM_IMPORT("write.regs");
 uint32_t weval_specialize_value(uint32_t value, uint32_t lo, uint32_t hi)
     WEVAL_WASM_IMPORT("specialize.value");
+/* 64-bit variant of weval_specialize_value(): generates a separate
+ * specialized body for each value in `lo..hi` inclusive. */
+uint64_t weval_specialize_value64(uint64_t value, uint64_t lo, uint64_t hi)
+    WEVAL_WASM_IMPORT("specialize.value64");
+/* Masked variant: returns the extracted field `(value & mask) >>
+ * ctz(mask)` and specializes on that field, with `lo`/`hi` bounding
+ * the field rather than the raw value. This lets a type tag in the
+ * high bits of a NaN-boxed word become a specialization-time constant
+ * while the payload bits stay dynamic: switch on the returned field
+ * rather than re-extracting it from `value`. `mask` must be a
+ * specialization-time constant. */
+uint64_t weval_specialize_value64_masked(uint64_t value, uint64_t mask,
+                                         uint64_t lo, uint64_t hi)
+    WEVAL_WASM_IMPORT("specialize.value64.masked");
+/* Inline-cache variant: rather than a dense switch over `lo..hi`,
+ * generates a compare-and-branch chain over the `n` candidate values
+ * in `expected`, each arm specialized as if `value` were that
+ * constant, with a final generic arm for values outside the cache.
+ * Use this for dynamic-dispatch sites (property access, virtual
+ * calls) where a few likely values dominate: monomorphic and
+ * slightly-polymorphic sites get constant-folded fast paths without
+ * paying for the full value range. `expected` and `n` must be
+ * specialization-time constants (e.g. a static table); candidates are
+ * tried in order, so put the most likely first. */
+uint32_t weval_specialize_cached(uint32_t value, const uint32_t* expected,
+                                 uint32_t n)
+    WEVAL_WASM_IMPORT("specialize.cached");
 uint64_t weval_read_specialization_global(uint32_t index)
     WEVAL_WASM_IMPORT("read.specialization.global");
+/* Bulk form: materializes specialization globals `base..base+count`
+ * (exclusive) into the contiguous 8-byte-stride region at `out`, in
+ * one intrinsic call. All globals in the window must have
+ * specialization-time-constant values; `base` and `count` must be
+ * constants too. Prefer weval_read_specialization_global where a
+ * single global feeds directly into specialized code (the value is
+ * aliased rather than stored); use this to set up a block of globals
+ * (isolate pointer, dispatch-table base, feature flags) at function
+ * entry without one imported call per global. */
+void weval_read_specialization_globals(uint32_t base, uint32_t count,
+                                       uint64_t* out)
+    WEVAL_WASM_IMPORT("read.specialization.globals");
+
+/* Assumption intrinsics: promises from the guest that let the
+ * specializer delete guarded slow paths (e.g. interpreter bounds
+ * checks under a validated-bytecode contract). A violated assumption
+ * is a guest bug: generic execution traps, and specialized code may
+ * misbehave arbitrarily. */
+
+/* Returns `value`, assumed to lie in `lo..hi` inclusive. Comparisons
+ * of the result (and of in-bounds constant offsets from it) against
+ * constants are folded at specialization time when the range makes
+ * them conclusive. A specialization-time-constant `value` outside the
+ * range fails specialization. */
+uint32_t weval_assume_range(uint32_t value, uint32_t lo, uint32_t hi)
+    WEVAL_WASM_IMPORT("assume.range");
+uint64_t weval_assume_range64(uint64_t value, uint64_t lo, uint64_t hi)
+    WEVAL_WASM_IMPORT("assume.range64");
+/* Marks a point the guest guarantees is never reached; both the
+ * specializer and the generic fallback replace it with a trap. */
+void weval_assume_unreachable() WEVAL_WASM_IMPORT("assume.unreachable");
+
+/* Execution-frequency hints. Wasm bytecode gives the weval tool no
+ * direct control over final machine-code placement -- the engine
+ * compiling the output module lays out its own code -- so these hints
+ * do not reorder blocks today. They are still worth placing: a
+ * context marked cold is flagged in the `--profile-out` profile (so
+ * cold code bloating a hot specialized function can be found and
+ * tiered down or un-specialized), expectations that fold at
+ * specialization time are checked and reported under `--show-stats`
+ * (a "missed" hint marks a branch that is not as predictable as
+ * assumed), and both elide to nothing in specialized and generic
+ * code. */
+
+/* Marks the current specialization context as rarely executed. */
+void weval_hint_cold() WEVAL_WASM_IMPORT("hint.cold");
+/* Returns `value`, hinting that it usually equals `expected` (a
+ * specialization-time constant). */
+uint32_t weval_expect32(uint32_t value, uint32_t expected)
+    WEVAL_WASM_IMPORT("expect32");
 
 /* Operand-stack virtualization */
 
@@ -175,6 +642,32 @@ void weval_write_stack(uint64_t* ptr, uint32_t index, uint64_t value)
  * effect never occurs). */
 uint64_t weval_pop_stack(uint64_t* ptr) WEVAL_WASM_IMPORT("pop.stack");
 
+/* Bulk operand-stack forms. Each moves `n` entries between the stack
+ * window whose lowest-addressed slot is `ptr` and a contiguous
+ * 8-byte-stride region, in one intrinsic call; slot `ptr[k]` pairs
+ * with region entry `k`, so the last region entry is the top of
+ * stack. `n` must be a specialization-time constant. */
+
+/* Push `n` entries, loaded from `in`; `in[n-1]` becomes the new top
+ * of stack. */
+void weval_pushn_stack(uint64_t* ptr, uint32_t n, const uint64_t* in)
+    WEVAL_WASM_IMPORT("pushn.stack");
+/* Pop `n` entries into `out`, canceling their pending stores;
+ * `out[n-1]` receives the old top of stack. Values of virtual entries
+ * are materialized through `out` rather than aliased, so prefer
+ * weval_pop_stack where a popped value feeds directly into
+ * specialized code. */
+void weval_popn_stack(uint64_t* ptr, uint32_t n, uint64_t* out)
+    WEVAL_WASM_IMPORT("popn.stack");
+/* Copy the top `n` entries into `out` without popping. */
+void weval_readn_stack(uint64_t* ptr, uint32_t n, uint64_t* out)
+    WEVAL_WASM_IMPORT("readn.stack");
+/* Synchronize only entries deeper than the top `keep` to the actual
+ * stack, leaving the top `keep` entries virtual. Unlike
+ * weval_sync_stack(), locals are not flushed. */
+void weval_sync_stack_partial(uint32_t keep)
+    WEVAL_WASM_IMPORT("sync.stack.partial");
+
 /* Locals virtualization; locals are also flushed when the stack is
  * flushed */
 
@@ -183,6 +676,26 @@ uint64_t weval_read_local(const uint64_t* ptr, uint32_t index)
 void weval_write_local(uint64_t* ptr, uint32_t index, uint64_t value)
     WEVAL_WASM_IMPORT("write.local");
 
+/* Declares the contiguous region of `count` 8-byte slots at `ptr`
+ * private to the specialized function, and returns the (tagged)
+ * pointer. Plain 8-byte loads and stores at constant offsets from the
+ * returned pointer are then SSA-promoted like virtualized locals --
+ * stores are held back until a sync point and re-reads fold to the
+ * pending value -- without wrapping each access in
+ * weval_read_local()/weval_write_local(). Use the returned pointer
+ * for all frame accesses; accesses through the original pointer (or
+ * any copy that did not flow through the return value) bypass the
+ * promotion. Narrower or misaligned accesses are legal but spill
+ * overlapping slots back to memory first.
+ *
+ * "Private" means nothing else may observe the region between sync
+ * points: do not pass the frame pointer to a callee (or otherwise let
+ * it escape) without an intervening weval_sync_stack(), which flushes
+ * pending frame stores along with locals. `count` must be a
+ * specialization-time constant. */
+uint64_t* weval_promote_frame(uint64_t* ptr, uint32_t count)
+    WEVAL_WASM_IMPORT("promote.frame");
+
 /* Debugging and stats intrinsics */
     
 void weval_trace_line(uint32_t line_number) WEVAL_WASM_IMPORT("trace.line");
@@ -193,6 +706,57 @@ void weval_assert_const32(uint32_t value, uint32_t line_no)
 void weval_print(const char* message, uint32_t line, uint32_t val)
     WEVAL_WASM_IMPORT("print");
 void weval_context_bucket(uint32_t bucket) WEVAL_WASM_IMPORT("context.bucket");
+/* Attach a human-readable name (a constant NUL-terminated string) to
+ * the current specialization context. Purely diagnostic: the name
+ * shows up in the per-context profile emitted by the weval tool's
+ * `--profile-out` flag, attributing specialized blocks and
+ * instructions to e.g. an opcode handler. */
+void weval_context_name(const char* name) WEVAL_WASM_IMPORT("context.name");
+
+/* Buffered tracing. weval_trace_line()/weval_print() are one imported
+ * call per event, which is too expensive to leave enabled in deployed
+ * images. Instead, write fixed-size records into a ring buffer in
+ * linear memory with plain stores and hand them to the weval tool in
+ * batches with weval_trace_flush(). Outside the tool the flush is a
+ * no-op, so always-on tracing costs only the stores; under the tool,
+ * records visible at a flush point with a specialization-time-constant
+ * pointer and count are logged. */
+
+typedef struct weval_trace_record_t {
+  uint32_t line;
+  uint32_t kind;
+  uint64_t value;
+} weval_trace_record_t;
+
+void weval_trace_flush(const weval_trace_record_t* records, uint32_t n)
+    WEVAL_WASM_IMPORT("trace.flush");
+
+/* Convenience ring-buffer layer over weval_trace_flush(). The caller
+ * provides the storage; recording auto-flushes when the ring fills. */
+
+typedef struct weval_trace_ring_t {
+  weval_trace_record_t* records;
+  uint32_t cap;
+  uint32_t head;
+} weval_trace_ring_t;
+
+static inline void weval_trace_ring_flush(weval_trace_ring_t* ring) {
+  weval_trace_flush(ring->records, ring->head);
+  ring->head = 0;
+}
+
+static inline void weval_trace_ring_record(weval_trace_ring_t* ring,
+                                           uint32_t line, uint32_t kind,
+                                           uint64_t value) {
+  weval_trace_record_t* record = &ring->records[ring->head];
+  record->line = line;
+  record->kind = kind;
+  record->value = value;
+  ring->head++;
+  if (ring->head == ring->cap) {
+    weval_trace_ring_flush(ring);
+  }
+}
 
 #undef WEVAL_WASM_IMPORT
 
@@ -205,6 +769,39 @@ namespace weval {
 static inline void push_context(uint32_t pc) { weval_push_context(pc); }
 static inline void pop_context() { weval_pop_context(); }
 static inline void update_context(uint32_t pc) { weval_update_context(pc); }
+static inline uint32_t assume_range(uint32_t value, uint32_t lo, uint32_t hi) {
+  return weval_assume_range(value, lo, hi);
+}
+static inline uint64_t assume_range64(uint64_t value, uint64_t lo,
+                                      uint64_t hi) {
+  return weval_assume_range64(value, lo, hi);
+}
+static inline void assume_unreachable() { weval_assume_unreachable(); }
+static inline void hint_cold() { weval_hint_cold(); }
+static inline uint32_t expect32(uint32_t value, uint32_t expected) {
+  return weval_expect32(value, expected);
+}
+
+/* Typed view of one specialization global. `Index` is a compile-time
+ * constant, so the intrinsic's argument is always foldable and the
+ * read melts into a constant in specialized code. `T` must be
+ * trivially copyable and at most 8 bytes; the global's low bits are
+ * reinterpreted as a `T` (so pointers and integer handles round-trip
+ * through the u64 slot unchanged). */
+template <uint32_t Index, typename T = uint64_t>
+static inline T specialization_global() {
+  static_assert(std::is_trivially_copyable<T>::value && sizeof(T) <= 8,
+                "Specialization global must be a trivially-copyable value of "
+                "at most 8 bytes");
+  uint64_t bits = weval_read_specialization_global(Index);
+  T value;
+  memcpy(&value, &bits, sizeof(T));
+  return value;
+}
+static inline void read_specialization_globals(uint32_t base, uint32_t count,
+                                               uint64_t* out) {
+  weval_read_specialization_globals(base, count, out);
+}
 }  // namespace weval
 #endif  // __cplusplus
 
@@ -215,14 +812,31 @@ static inline void update_context(uint32_t pc) { weval_update_context(pc); }
 #ifdef __cplusplus
 namespace weval {
 
+/* Sanity ceiling on a single request's argbuf. Inline buffer args
+ * (`SpecializeMemory`) are copied into the argbuf, so a guest that
+ * legitimately embeds more than this should either raise the ceiling
+ * by defining `WEVAL_ARGWRITER_MAX` before including this header, or
+ * -- better -- pass the data by reference with `SpecializeMemoryRef`
+ * or `SpecializeMemoryChunked`, which keep the argbuf small no matter
+ * how large the constant memory is. */
+#ifndef WEVAL_ARGWRITER_MAX
+#define WEVAL_ARGWRITER_MAX (1024 * 1024)
+#endif
+
 struct ArgWriter {
-  static const size_t MAX = 1024 * 1024;
+  static const size_t MAX = WEVAL_ARGWRITER_MAX;
 
   uint8_t* buffer;
   size_t len;
   size_t cap;
+  /* If non-null, the buffer is carved out of this arena rather than
+   * malloc'd; growth copies into a fresh arena block (the old block
+   * stays in the arena until it is bulk-freed). */
+  weval_req_arena_t* arena;
 
-  ArgWriter() : buffer(nullptr), len(0), cap(0) {}
+  ArgWriter() : buffer(nullptr), len(0), cap(0), arena(nullptr) {}
+  explicit ArgWriter(weval_req_arena_t* arena_)
+      : buffer(nullptr), len(0), cap(0), arena(arena_) {}
 
   uint8_t* alloc(size_t bytes) {
     if (bytes + len > MAX) {
@@ -233,9 +847,21 @@ struct ArgWriter {
       while (desired_cap < (len + bytes)) {
         desired_cap *= 2;
       }
-      buffer = reinterpret_cast<uint8_t*>(realloc(buffer, desired_cap));
-      if (!buffer) {
-        return nullptr;
+      if (arena) {
+        uint8_t* new_buffer = reinterpret_cast<uint8_t*>(
+            weval_arena_alloc(arena, desired_cap));
+        if (!new_buffer) {
+          return nullptr;
+        }
+        if (len > 0) {
+          memcpy(new_buffer, buffer, len);
+        }
+        buffer = new_buffer;
+      } else {
+        buffer = reinterpret_cast<uint8_t*>(realloc(buffer, desired_cap));
+        if (!buffer) {
+          return nullptr;
+        }
       }
       cap = desired_cap;
     }
@@ -244,6 +870,36 @@ struct ArgWriter {
     return ret;
   }
 
+  /* Pre-size the buffer to exactly `total` bytes so that subsequent
+   * writes perform no further allocation (or copying, in arena
+   * mode). */
+  bool reserve(size_t total) {
+    if (total > MAX) {
+      return false;
+    }
+    if (total <= cap) {
+      return true;
+    }
+    if (arena) {
+      uint8_t* new_buffer =
+          reinterpret_cast<uint8_t*>(weval_arena_alloc(arena, total));
+      if (!new_buffer) {
+        return false;
+      }
+      if (len > 0) {
+        memcpy(new_buffer, buffer, len);
+      }
+      buffer = new_buffer;
+    } else {
+      buffer = reinterpret_cast<uint8_t*>(realloc(buffer, total));
+      if (!buffer) {
+        return false;
+      }
+    }
+    cap = total;
+    return true;
+  }
+
   template <typename T>
   bool write(T t) {
     uint8_t* mem = alloc(sizeof(T));
@@ -283,83 +939,379 @@ struct Specialize : ArgSpec<T> {
 template <typename T>
 struct SpecializeMemory : ArgSpec<T> {
   T ptr;
-  uint32_t len;
-  SpecializeMemory(T ptr_, uint32_t len_) : ptr(ptr_), len(len_) {}
+  size_t len;
+  SpecializeMemory(T ptr_, size_t len_) : ptr(ptr_), len(len_) {}
   SpecializeMemory(const SpecializeMemory& other) = default;
 };
 
+/*
+ * Like `SpecializeMemory`, but passes the buffer by reference: no
+ * copy is made into the request's argbuf, and the weval tool reads
+ * the constant contents directly out of the snapshotted heap. Use
+ * this for large buffers (bytecode images, say) that already live in
+ * the heap for the program's own use and will not be mutated between
+ * registration and the snapshot; it halves their footprint in the
+ * image. Use `SpecializeMemory` for buffers the caller intends to
+ * mutate after registration.
+ */
+template <typename T>
+struct SpecializeMemoryRef : ArgSpec<T> {
+  T ptr;
+  size_t len;
+  SpecializeMemoryRef(T ptr_, size_t len_) : ptr(ptr_), len(len_) {}
+  SpecializeMemoryRef(const SpecializeMemoryRef& other) = default;
+};
+
+/*
+ * Like `SpecializeMemoryRef`, but the constant contents are given as
+ * a sequence of segments that the weval tool logically concatenates:
+ * the evaluator sees the parameter as a pointer to one constant
+ * buffer holding the segments' bytes back to back, starting at offset
+ * 0. Use this when the constant data exceeds the argbuf ceiling
+ * (`WEVAL_ARGWRITER_MAX`) or is not contiguous in the heap -- a
+ * bytecode bundle built in chunks, say. Note that no contiguous copy
+ * exists at runtime: the wasm-level parameter holds a pointer to the
+ * segment table, not to the concatenated contents. The generic
+ * (unspecialized) function therefore must not rely on dereferencing
+ * this parameter directly; pass the segment table through another arg
+ * if the generic path needs to walk the data. The same holds inside
+ * the specialized function: every access through this parameter must
+ * fold at specialization time, and the weval tool fails the request
+ * (falling back to the generic function) if the parameter's value
+ * would escape into the specialized body, where a residual access
+ * would read the segment table instead of the buffered contents. The
+ * segment array and the segment contents must stay live and unmutated
+ * between registration and the snapshot.
+ */
+template <typename T>
+struct SpecializeMemoryChunked : ArgSpec<T> {
+  const weval_buffer_seg_t* segs;
+  size_t count;
+  SpecializeMemoryChunked(const weval_buffer_seg_t* segs_, size_t count_)
+      : segs(segs_), count(count_) {}
+  SpecializeMemoryChunked(const SpecializeMemoryChunked& other) = default;
+};
+
 namespace impl {
 template <typename Ret, typename... Args>
 using FuncPtr = Ret (*)(Args...);
 
+/* 64-bit FNV-1a, used for content-hashing request bodies. */
+static const uint64_t kFnv1a64OffsetBasis = 14695981039346656037ULL;
+static const uint64_t kFnv1a64Prime = 1099511628211ULL;
+
+inline uint64_t fnv1a_64(const void* data, size_t len, uint64_t hash) {
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+  for (size_t i = 0; i < len; i++) {
+    hash ^= bytes[i];
+    hash *= kFnv1a64Prime;
+  }
+  return hash;
+}
+
+/* constexpr FNV-1a over a NUL-terminated string, for compile-time
+ * derived target IDs. */
+constexpr uint64_t fnv1a_64_str(const char* s,
+                                uint64_t hash = kFnv1a64OffsetBasis) {
+  while (*s) {
+    hash ^= static_cast<uint8_t>(*s++);
+    hash *= kFnv1a64Prime;
+  }
+  return hash;
+}
+
+/* The stable symbol token a derived target ID is hashed from: the
+ * compiler's signature string for this function embeds the template
+ * argument's fully qualified name. Stable across builds and relinks
+ * with the same compiler; the exact spelling (and so the ID) is
+ * compiler-specific, which is fine for cache identity as long as the
+ * toolchain is held fixed alongside the cache. */
+template <auto F>
+constexpr const char* target_token() {
+  return __PRETTY_FUNCTION__;
+}
+
+template <auto F>
+constexpr uint32_t derived_target_id() {
+  uint64_t h = fnv1a_64_str(target_token<F>());
+  /* XOR-fold to the 32-bit `user_id` width. */
+  return static_cast<uint32_t>(h ^ (h >> 32));
+}
+
+/* Registry of derived IDs, used to catch hash collisions
+ * deterministically at registration time: two distinct targets
+ * hashing to the same ID would silently share a cache/dedup identity
+ * otherwise. One node per instantiation of `weval::target()`;
+ * comparison is by token *contents* since each translation unit gets
+ * its own copy of the signature string. */
+struct TargetIdRegistration {
+  uint32_t id;
+  const char* token;
+  TargetIdRegistration* next;
+};
+
+inline TargetIdRegistration*& target_id_registry() {
+  static TargetIdRegistration* head = nullptr;
+  return head;
+}
+
+inline void register_target_id(TargetIdRegistration* reg) {
+  for (TargetIdRegistration* p = target_id_registry(); p; p = p->next) {
+    if (p->id == reg->id) {
+      if (strcmp(p->token, reg->token) != 0) {
+        /* Derived-ID collision between distinct targets; perturb one
+         * of them with an explicit hand-assigned ID. */
+        abort();
+      }
+      return;
+    }
+  }
+  reg->next = target_id_registry();
+  target_id_registry() = reg;
+}
+
+/*
+ * Argument-record writers, shared by the `StoreArg`/`StoreArgs`
+ * encoders below. Each helper emits one argument in the encoding
+ * selected at compile time: the legacy (v1) format is an array of
+ * 16-byte `weval_req_arg_t` records with buffer data padded to 8
+ * bytes; the packed (v2) format, enabled with `WEVAL_PACKED_ARGS=1`
+ * and signalled to the weval tool via `WEVAL_REQ_FLAG_ARGS_V2`,
+ * spends one tag byte per argument (a `weval_req_arg_type` value, or
+ * `weval_req_arg_none` for runtime args), a 4-byte slot for i32/f32
+ * and an 8-byte slot for i64/f64, and encodes buffer lengths and
+ * pointers as ULEB128 with no alignment padding.
+ */
+
+#if WEVAL_PACKED_ARGS
+inline bool write_uleb(ArgWriter& args, uint64_t value) {
+  do {
+    uint8_t byte = value & 0x7f;
+    value >>= 7;
+    if (value != 0) {
+      byte |= 0x80;
+    }
+    if (!args.write(byte)) {
+      return false;
+    }
+  } while (value != 0);
+  return true;
+}
+#endif
+
+inline bool write_arg_scalar32(ArgWriter& args, weval_req_arg_type ty,
+                               uint32_t bits) {
+#if WEVAL_PACKED_ARGS
+  return args.write(static_cast<uint8_t>(ty)) && args.write(bits);
+#else
+  weval_req_arg_t arg;
+  arg.specialize = 1;
+  arg.ty = ty;
+  arg.u.raw = 0;
+  arg.u.i32 = bits;
+  return args.write(arg);
+#endif
+}
+
+inline bool write_arg_scalar64(ArgWriter& args, weval_req_arg_type ty,
+                               uint64_t bits) {
+#if WEVAL_PACKED_ARGS
+  return args.write(static_cast<uint8_t>(ty)) && args.write(bits);
+#else
+  weval_req_arg_t arg;
+  arg.specialize = 1;
+  arg.ty = ty;
+  arg.u.raw = 0;
+  arg.u.i64 = bits;
+  return args.write(arg);
+#endif
+}
+
+inline bool write_arg_runtime(ArgWriter& args) {
+#if WEVAL_PACKED_ARGS
+  return args.write(static_cast<uint8_t>(weval_req_arg_none));
+#else
+  weval_req_arg_t arg;
+  arg.specialize = 0;
+  arg.ty = weval_req_arg_none;
+  arg.u.raw = 0;
+  return args.write(arg);
+#endif
+}
+
+inline bool write_arg_buffer(ArgWriter& args, const void* src, size_t len) {
+#if WEVAL_PACKED_ARGS
+  if (!args.write(static_cast<uint8_t>(weval_req_arg_buffer)) ||
+      !write_uleb(args, len)) {
+    return false;
+  }
+  uint8_t* dst = args.alloc(len);
+  if (!dst) {
+    return false;
+  }
+  memcpy(dst, src, len);
+  return true;
+#else
+  /* The legacy record's length fields are 32-bit; the wasm64 guard
+   * above ensures this path only runs on wasm32, where `size_t`
+   * fits. */
+  weval_req_arg_t arg;
+  arg.specialize = 1;
+  arg.ty = weval_req_arg_buffer;
+  arg.u.raw = 0;
+  arg.u.buffer.len = (uint32_t)len;
+  arg.u.buffer.padded_len = ((uint32_t)len + 7) & ~(uint32_t)7;
+  if (!args.write(arg)) {
+    return false;
+  }
+  uint8_t* dst = args.alloc(arg.u.buffer.padded_len);
+  if (!dst) {
+    return false;
+  }
+  memcpy(dst, src, len);
+  if (arg.u.buffer.padded_len > len) {
+    /* Ensure deterministic (zeroed) padding bytes. */
+    memset(dst + len, 0, arg.u.buffer.padded_len - len);
+  }
+  return true;
+#endif
+}
+
+inline bool write_arg_buffer_ref(ArgWriter& args, uintptr_t ptr, size_t len) {
+#if WEVAL_PACKED_ARGS
+  return args.write(static_cast<uint8_t>(weval_req_arg_buffer_ref)) &&
+         write_uleb(args, ptr) && write_uleb(args, len);
+#else
+  weval_req_arg_t arg;
+  arg.specialize = 1;
+  arg.ty = weval_req_arg_buffer_ref;
+  arg.u.raw = 0;
+  arg.u.buffer_ref.ptr = (uint32_t)ptr;
+  arg.u.buffer_ref.len = (uint32_t)len;
+  return args.write(arg);
+#endif
+}
+
+inline bool write_arg_buffer_chunked(ArgWriter& args,
+                                     const weval_buffer_seg_t* segs,
+                                     size_t count) {
+#if WEVAL_PACKED_ARGS
+  if (!args.write(static_cast<uint8_t>(weval_req_arg_buffer_chunked)) ||
+      !write_uleb(args, count)) {
+    return false;
+  }
+  for (size_t i = 0; i < count; i++) {
+    if (!write_uleb(args, segs[i].ptr) || !write_uleb(args, segs[i].len)) {
+      return false;
+    }
+  }
+  return true;
+#else
+  /* The segment array itself stays in the live heap; the record only
+   * points at it. */
+  weval_req_arg_t arg;
+  arg.specialize = 1;
+  arg.ty = weval_req_arg_buffer_chunked;
+  arg.u.raw = 0;
+  arg.u.buffer_chunks.segs = (uint32_t)(uintptr_t)segs;
+  arg.u.buffer_chunks.count = (uint32_t)count;
+  return args.write(arg);
+#endif
+}
+
+/*
+ * Generic case: a trivially-copyable `T` is specialized on by
+ * encoding its object representation inline. Scalar types of up to 8
+ * bytes are packed into a single i32/i64 scalar arg; aggregates
+ * larger than 8 bytes are encoded as an inline constant-content
+ * buffer (exactly as `SpecializeMemory` would encode them, without
+ * hand-computed sizes), matching the wasm C ABI's indirect (by
+ * pointer) passing of such parameters.
+ *
+ * The encoding must match the wasm-level lowering of the parameter,
+ * and the wasm C ABI passes *any* multi-field aggregate indirectly --
+ * including ones of 8 bytes or fewer, for which the scalar packing
+ * would be silently wrong (the constant would be matched against a
+ * parameter that actually holds a pointer). The static_assert below
+ * therefore rejects small non-scalar types outright: specialize on
+ * the scalar member directly, or pass the aggregate by (const)
+ * pointer and specialize the pointee with `SpecializeMemory`.
+ *
+ * Padding bytes participate in the encoding (and so in request
+ * identity under `DedupIndex`); value-initialize aggregates that have
+ * padding.
+ */
 template <typename T>
-struct StoreArg;
+struct StoreArg {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "Only trivially-copyable types can be specialized on");
+  static_assert(std::is_scalar<T>::value || sizeof(T) > 8,
+                "Small aggregates are passed indirectly by the wasm C ABI and "
+                "cannot be encoded as a scalar; specialize on the scalar "
+                "member directly, or pass by pointer and use SpecializeMemory "
+                "on the pointee");
+  bool operator()(ArgWriter& args, const T& value) {
+    if (sizeof(T) <= 4) {
+      uint32_t bits = 0;
+      memcpy(&bits, &value, sizeof(T));
+      return write_arg_scalar32(args, weval_req_arg_i32, bits);
+    } else if (sizeof(T) <= 8) {
+      uint64_t bits = 0;
+      memcpy(&bits, &value, sizeof(T));
+      return write_arg_scalar64(args, weval_req_arg_i64, bits);
+    } else {
+      return write_arg_buffer(args, &value, sizeof(T));
+    }
+  }
+};
 
 template <>
 struct StoreArg<uint32_t> {
   bool operator()(ArgWriter& args, uint32_t value) {
-    weval_req_arg_t arg;
-    arg.specialize = 1;
-    arg.ty = weval_req_arg_i32;
-    arg.u.raw = 0;
-    arg.u.i32 = value;
-    return args.write(arg);
+    return write_arg_scalar32(args, weval_req_arg_i32, value);
   }
 };
 template <>
 struct StoreArg<bool> {
   bool operator()(ArgWriter& args, bool value) {
-    weval_req_arg_t arg;
-    arg.specialize = 1;
-    arg.ty = weval_req_arg_i32;
-    arg.u.raw = 0;
-    arg.u.i32 = value ? 1 : 0;
-    return args.write(arg);
+    return write_arg_scalar32(args, weval_req_arg_i32, value ? 1 : 0);
   }
 };
 template <>
 struct StoreArg<uint64_t> {
   bool operator()(ArgWriter& args, uint64_t value) {
-    weval_req_arg_t arg;
-    arg.specialize = 1;
-    arg.ty = weval_req_arg_i64;
-    arg.u.raw = 0;
-    arg.u.i64 = value;
-    return args.write(arg);
+    return write_arg_scalar64(args, weval_req_arg_i64, value);
   }
 };
 template <>
 struct StoreArg<float> {
   bool operator()(ArgWriter& args, float value) {
-    weval_req_arg_t arg;
-    arg.specialize = 1;
-    arg.ty = weval_req_arg_f32;
-    arg.u.raw = 0;
-    arg.u.f32 = value;
-    return args.write(arg);
+    uint32_t bits = 0;
+    memcpy(&bits, &value, sizeof(float));
+    return write_arg_scalar32(args, weval_req_arg_f32, bits);
   }
 };
 template <>
 struct StoreArg<double> {
   bool operator()(ArgWriter& args, double value) {
-    weval_req_arg_t arg;
-    arg.specialize = 1;
-    arg.ty = weval_req_arg_f64;
-    arg.u.raw = 0;
-    arg.u.f64 = value;
-    return args.write(arg);
+    uint64_t bits = 0;
+    memcpy(&bits, &value, sizeof(double));
+    return write_arg_scalar64(args, weval_req_arg_f64, bits);
   }
 };
 template <typename T>
 struct StoreArg<T*> {
   bool operator()(ArgWriter& args, T* value) {
-    static_assert(sizeof(T*) == 4, "Only 32-bit Wasm supported");
-    weval_req_arg_t arg;
-    arg.specialize = 1;
-    arg.ty = weval_req_arg_i32;
-    arg.u.raw = 0;
-    arg.u.i32 = reinterpret_cast<uint32_t>(value);
-    return args.write(arg);
+    /* A pointer parameter lowers to i32 on wasm32 and i64 on wasm64;
+     * the encoded scalar type must match. */
+    if (sizeof(T*) == 8) {
+      return write_arg_scalar64(
+          args, weval_req_arg_i64,
+          static_cast<uint64_t>(reinterpret_cast<uintptr_t>(value)));
+    }
+    return write_arg_scalar32(
+        args, weval_req_arg_i32,
+        static_cast<uint32_t>(reinterpret_cast<uintptr_t>(value)));
   }
 };
 template <typename T>
@@ -371,13 +1323,97 @@ struct StoreArg<T&> {
 template <typename T>
 struct StoreArg<const T*> {
   bool operator()(ArgWriter& args, const T* value) {
-    static_assert(sizeof(const T*) == 4, "Only 32-bit Wasm supported");
-    weval_req_arg_t arg;
-    arg.specialize = 1;
-    arg.ty = weval_req_arg_i32;
-    arg.u.raw = 0;
-    arg.u.i32 = reinterpret_cast<uint32_t>(value);
-    return args.write(arg);
+    return StoreArg<T*>()(args, const_cast<T*>(value));
+  }
+};
+
+/*
+ * Computes the encoded size of a wrapped-argument list before any of
+ * it is written, so that `weval()` can size the argbuf with a single
+ * allocation instead of doubling through `realloc`. In the legacy
+ * encoding the size is exact; in the packed encoding ULEB128 fields
+ * are counted at their maximum (5-byte) width, so the computed size
+ * is a tight upper bound.
+ */
+#if WEVAL_PACKED_ARGS
+/* Tag byte plus a worst-case (64-bit) ULEB128 length/pointer field. */
+static const size_t kPackedArgHeaderMax = 1 + 10;
+#endif
+
+template <typename... Args>
+struct ArgsSize {};
+
+template <>
+struct ArgsSize<> {
+  size_t operator()() { return 0; }
+};
+
+template <typename T, typename... Rest>
+struct ArgsSize<Specialize<T>, Rest...> {
+  size_t operator()(const Specialize<T>&, const Rest&... rest) {
+#if WEVAL_PACKED_ARGS
+    size_t self = sizeof(T) <= 4   ? 1 + 4
+                  : sizeof(T) <= 8 ? 1 + 8
+                                   : kPackedArgHeaderMax + sizeof(T);
+#else
+    /* Aggregates larger than a scalar are encoded by `StoreArg<T>` as
+     * an inline buffer; account for the padded data too. */
+    size_t data_len = sizeof(T) <= 8 ? 0 : ((sizeof(T) + 7) & ~(size_t)7);
+    size_t self = sizeof(weval_req_arg_t) + data_len;
+#endif
+    return self + ArgsSize<Rest...>()(rest...);
+  }
+};
+
+template <typename T, typename... Rest>
+struct ArgsSize<SpecializeMemory<T>, Rest...> {
+  size_t operator()(const SpecializeMemory<T>& arg0, const Rest&... rest) {
+#if WEVAL_PACKED_ARGS
+    size_t self = kPackedArgHeaderMax + size_t(arg0.len);
+#else
+    size_t padded_len = (size_t(arg0.len) + 7) & ~(size_t)7;
+    size_t self = sizeof(weval_req_arg_t) + padded_len;
+#endif
+    return self + ArgsSize<Rest...>()(rest...);
+  }
+};
+
+template <typename T, typename... Rest>
+struct ArgsSize<SpecializeMemoryRef<T>, Rest...> {
+  size_t operator()(const SpecializeMemoryRef<T>&, const Rest&... rest) {
+#if WEVAL_PACKED_ARGS
+    size_t self = kPackedArgHeaderMax + 10;
+#else
+    size_t self = sizeof(weval_req_arg_t);
+#endif
+    return self + ArgsSize<Rest...>()(rest...);
+  }
+};
+
+template <typename T, typename... Rest>
+struct ArgsSize<SpecializeMemoryChunked<T>, Rest...> {
+  size_t operator()(const SpecializeMemoryChunked<T>& arg0,
+                    const Rest&... rest) {
+#if WEVAL_PACKED_ARGS
+    /* Tag and count, then a worst-case pointer/length ULEB128 pair
+     * per segment. */
+    size_t self = kPackedArgHeaderMax + arg0.count * 20;
+#else
+    size_t self = sizeof(weval_req_arg_t);
+#endif
+    return self + ArgsSize<Rest...>()(rest...);
+  }
+};
+
+template <typename T, typename... Rest>
+struct ArgsSize<RuntimeArg<T>, Rest...> {
+  size_t operator()(const RuntimeArg<T>&, const Rest&... rest) {
+#if WEVAL_PACKED_ARGS
+    size_t self = 1;
+#else
+    size_t self = sizeof(weval_req_arg_t);
+#endif
+    return self + ArgsSize<Rest...>()(rest...);
   }
 };
 
@@ -402,25 +1438,33 @@ struct StoreArgs<Specialize<T>, Rest...> {
 template <typename T, typename... Rest>
 struct StoreArgs<SpecializeMemory<T>, Rest...> {
   bool operator()(ArgWriter& args, SpecializeMemory<T> arg0, Rest... rest) {
-    weval_req_arg_t arg;
-    arg.specialize = 1;
-    arg.ty = weval_req_arg_buffer;
-    arg.u.raw = 0;
-    arg.u.buffer.len = arg0.len;
-    arg.u.buffer.padded_len = (arg0.len + 7) & ~7;  // Align to 8-byte boundary.
-    if (!args.write(arg)) {
+    if (!write_arg_buffer(args, reinterpret_cast<const void*>(arg0.ptr),
+                          arg0.len)) {
       return false;
     }
-    const uint8_t* src = reinterpret_cast<const uint8_t*>(arg0.ptr);
-    uint8_t* dst = args.alloc(arg.u.buffer.padded_len);
-    if (!dst) {
+    return StoreArgs<Rest...>()(args, rest...);
+  }
+};
+
+template <typename T, typename... Rest>
+struct StoreArgs<SpecializeMemoryRef<T>, Rest...> {
+  bool operator()(ArgWriter& args, SpecializeMemoryRef<T> arg0, Rest... rest) {
+    static_assert(sizeof(T) == sizeof(void*), "Buffer ref must be a pointer");
+    if (!write_arg_buffer_ref(args, reinterpret_cast<uintptr_t>(arg0.ptr),
+                              arg0.len)) {
       return false;
     }
-    memcpy(dst, src, arg0.len);
-    if (arg.u.buffer.padded_len > arg.u.buffer.len) {
-      // Ensure deterministic (zeroed) padding bytes.
-      memset(dst + arg.u.buffer.len, 0,
-             arg.u.buffer.padded_len - arg.u.buffer.len);
+    return StoreArgs<Rest...>()(args, rest...);
+  }
+};
+
+template <typename T, typename... Rest>
+struct StoreArgs<SpecializeMemoryChunked<T>, Rest...> {
+  bool operator()(ArgWriter& args, SpecializeMemoryChunked<T> arg0,
+                  Rest... rest) {
+    static_assert(sizeof(T) == sizeof(void*), "Buffer ref must be a pointer");
+    if (!write_arg_buffer_chunked(args, arg0.segs, arg0.count)) {
+      return false;
     }
     return StoreArgs<Rest...>()(args, rest...);
   }
@@ -429,11 +1473,7 @@ struct StoreArgs<SpecializeMemory<T>, Rest...> {
 template <typename T, typename... Rest>
 struct StoreArgs<RuntimeArg<T>, Rest...> {
   bool operator()(ArgWriter& args, RuntimeArg<T> arg0, Rest... rest) {
-    weval_req_arg_t arg;
-    arg.specialize = 0;
-    arg.ty = weval_req_arg_none;
-    arg.u.raw = 0;
-    if (!args.write(arg)) {
+    if (!write_arg_runtime(args)) {
       return false;
     }
     return StoreArgs<Rest...>()(args, rest...);
@@ -442,33 +1482,462 @@ struct StoreArgs<RuntimeArg<T>, Rest...> {
 
 }  // namespace impl
 
+namespace impl {
+/* Builds a request record without registering it on the pending
+ * list. */
 template <typename Ret, typename... Args, typename... WrappedArgs>
-weval_req_t* weval(impl::FuncPtr<Ret, Args...>* dest,
-                   impl::FuncPtr<Ret, Args...> generic, uint32_t func_id,
-                   uint32_t num_globals,
-                   WrappedArgs... args) {
-  weval_req_t* req = (weval_req_t*)malloc(sizeof(weval_req_t));
+weval_req_t* build_request(weval_req_arena_t* arena,
+                           impl::FuncPtr<Ret, Args...>* dest,
+                           impl::FuncPtr<Ret, Args...> generic,
+                           uint32_t func_id, uint32_t num_globals,
+                           WrappedArgs... args) {
+  weval_req_t* req =
+      arena ? (weval_req_t*)weval_arena_alloc(arena, sizeof(weval_req_t))
+            : (weval_req_t*)malloc(sizeof(weval_req_t));
   if (!req) {
     return nullptr;
   }
-  ArgWriter writer;
+  ArgWriter writer(arena);
+  if (!writer.reserve(impl::ArgsSize<WrappedArgs...>()(args...))) {
+    return nullptr;
+  }
   if (!impl::StoreArgs<WrappedArgs...>()(writer, args...)) {
     return nullptr;
   }
 
+  req->user_id = func_id;
   req->num_globals = num_globals;
   req->func = (weval_func_t)generic;
   req->arglen = writer.len;
   req->argbuf = writer.take();
   req->specialized = (weval_func_t*)dest;
+  req->flags = (arena ? WEVAL_REQ_FLAG_ARENA : 0) |
+               (WEVAL_PACKED_ARGS ? WEVAL_REQ_FLAG_ARGS_V2 : 0);
+  req->priority = 0;
+  req->content_hash = 0;
+
+  return req;
+}
 
+template <typename Ret, typename... Args, typename... WrappedArgs>
+weval_req_t* weval_impl(weval_req_arena_t* arena,
+                        impl::FuncPtr<Ret, Args...>* dest,
+                        impl::FuncPtr<Ret, Args...> generic, uint32_t func_id,
+                        uint32_t num_globals, WrappedArgs... args) {
+  weval_req_t* req =
+      build_request(arena, dest, generic, func_id, num_globals, args...);
+  if (!req) {
+    return nullptr;
+  }
   weval_request(req);
+  return req;
+}
+}  // namespace impl
+
+template <typename Ret, typename... Args, typename... WrappedArgs>
+weval_req_t* weval(impl::FuncPtr<Ret, Args...>* dest,
+                   impl::FuncPtr<Ret, Args...> generic, uint32_t func_id,
+                   uint32_t num_globals,
+                   WrappedArgs... args) {
+  return impl::weval_impl(nullptr, dest, generic, func_id, num_globals,
+                          args...);
+}
+
+/*
+ * Derives a function ID for the given specialization target at
+ * compile time, as a constexpr hash of the target's qualified name:
+ *
+ *     weval::weval(&dest, Interpret<true>,
+ *                  weval::target<&Interpret<true>>(), 0, args...);
+ *
+ * or, deriving the generic function pointer too:
+ *
+ *     weval::weval<&Interpret<true>>(&dest, 0, args...);
+ *
+ * This replaces a hand-maintained globally unique ID space: the ID is
+ * stable across builds and relinks (it depends only on the symbol
+ * name and the compiler), so it doubles as a cross-build cache
+ * identity, and large target populations can be registered
+ * mechanically without allocating enum entries. The first call per
+ * target records the ID in a registry and aborts if a *different*
+ * target already claimed it (a hash collision; vanishingly rare, and
+ * loud rather than silently merging two targets' identities).
+ *
+ * Taking the target's address here pins it in the indirect function
+ * table just as `WEVAL_DEFINE_TARGET()` would, so derived-ID targets
+ * need no per-target macro invocation or export.
+ */
+template <auto F>
+inline uint32_t target() {
+  static impl::TargetIdRegistration reg = {
+      impl::derived_target_id<F>(), impl::target_token<F>(), nullptr};
+  impl::register_target_id(&reg);
+  return reg.id;
+}
+
+/* As `weval()`, but with the generic function and its ID both derived
+ * from the target template argument; see `weval::target()`. */
+template <auto F, typename Ret, typename... Args, typename... WrappedArgs>
+weval_req_t* weval(impl::FuncPtr<Ret, Args...>* dest, uint32_t num_globals,
+                   WrappedArgs... args) {
+  return impl::weval_impl(nullptr, dest, F, target<F>(), num_globals, args...);
+}
 
+/* As `weval()`, but with an explicit priority: higher-priority
+ * requests are specialized first, and survive a specialization budget
+ * (`--max-specializations`) at the expense of lower-priority ones.
+ * Use this to tier hot functions above the long tail of cold ones. */
+template <typename Ret, typename... Args, typename... WrappedArgs>
+weval_req_t* weval_with_priority(impl::FuncPtr<Ret, Args...>* dest,
+                                 impl::FuncPtr<Ret, Args...> generic,
+                                 uint32_t func_id, uint32_t num_globals,
+                                 uint32_t priority, WrappedArgs... args) {
+  weval_req_t* req = impl::build_request(nullptr, dest, generic, func_id,
+                                         num_globals, args...);
+  if (!req) {
+    return nullptr;
+  }
+  req->priority = priority;
+  weval_request(req);
   return req;
 }
 
+/* As `weval()`, but allocates the request record and argbuf from the
+ * given arena so that registration is a bump-pointer operation. */
+template <typename Ret, typename... Args, typename... WrappedArgs>
+weval_req_t* weval(weval_req_arena_t* arena, impl::FuncPtr<Ret, Args...>* dest,
+                   impl::FuncPtr<Ret, Args...> generic, uint32_t func_id,
+                   uint32_t num_globals, WrappedArgs... args) {
+  return impl::weval_impl(arena, dest, generic, func_id, num_globals, args...);
+}
+
+/* As `weval()`, but appends the request by value to the contiguous
+ * pending table (`weval_req_pending_table`) rather than linking a
+ * heap-allocated record onto the pending list. Returns whether the
+ * append succeeded. */
+template <typename Ret, typename... Args, typename... WrappedArgs>
+bool weval_into_table(impl::FuncPtr<Ret, Args...>* dest,
+                      impl::FuncPtr<Ret, Args...> generic, uint32_t func_id,
+                      uint32_t num_globals, WrappedArgs... args) {
+  ArgWriter writer;
+  if (!writer.reserve(impl::ArgsSize<WrappedArgs...>()(args...))) {
+    return false;
+  }
+  if (!impl::StoreArgs<WrappedArgs...>()(writer, args...)) {
+    return false;
+  }
+  weval_req_t req;
+  req.next = nullptr;
+  req.prev = nullptr;
+  req.user_id = func_id;
+  req.num_globals = num_globals;
+  req.func = (weval_func_t)generic;
+  req.arglen = writer.len;
+  req.argbuf = writer.take();
+  req.specialized = (weval_func_t*)dest;
+  req.flags = WEVAL_PACKED_ARGS ? WEVAL_REQ_FLAG_ARGS_V2 : 0;
+  req.priority = 0;
+  req.content_hash = 0;
+  return weval_request_into_table(&req);
+}
+
 inline void free(weval_req_t* req) { weval_free(req); }
 
+/* The request-queue statistics block; see `weval_stats_t`. */
+inline const weval_stats_t& stats() { return weval_stats; }
+
+/* Stamps `req` with a stable content hash (FNV-1a over `salt`,
+ * `user_id`, and the argbuf bytes), so the weval tool's cache can
+ * recognize a semantically unchanged request even when its argbuf
+ * embeds heap addresses (buffer-ref pointers, runtime pointers
+ * specialized on) that differ between runs, and skip
+ * respecialization. Cached entries remain scoped to the input
+ * module's hash: the cached payload is compiled code that embeds the
+ * module's function/signature index assignment, so it cannot be
+ * safely reused across a relink. The function-table index in `func`
+ * is still excluded from the hash -- within one module image, the
+ * same logical request may be registered from call sites that resolve
+ * the target through different tables or orders. Use `salt` to fold
+ * in any identity the argbuf does not capture, and note that
+ * `SpecializeMemoryRef` and `SpecializeMemoryChunked` args embed heap
+ * *pointers* in the argbuf, so requests using them only hash stably
+ * if the buffers' addresses are themselves stable; prefer
+ * `SpecializeMemory` (inline contents) for hashed requests. Call
+ * after building the request but before the snapshot is taken. */
+inline void set_content_hash(weval_req_t* req, uint64_t salt) {
+  uint64_t h = impl::kFnv1a64OffsetBasis;
+  h = impl::fnv1a_64(&salt, sizeof(salt), h);
+  h = impl::fnv1a_64(&req->user_id, sizeof(req->user_id), h);
+  h = impl::fnv1a_64(req->argbuf, req->arglen, h);
+  if (h == 0) {
+    /* 0 means "no hash"; remap the (vanishingly unlikely) collision. */
+    h = impl::kFnv1a64OffsetBasis;
+  }
+  req->content_hash = h;
+  req->flags |= WEVAL_REQ_FLAG_CONTENT_HASH;
+}
+
+/*
+ * Opt-in content-based deduplication of requests at registration
+ * time.
+ *
+ * Embedders that register one request per call site (rather than per
+ * distinct function body) often enqueue many requests with identical
+ * contents -- the same generic function, ID, and argument encoding --
+ * and each duplicate costs a full specialization pass in the weval
+ * tool and a duplicate function body in the output module. An index
+ * shared across registrations hashes each request's content; when a
+ * duplicate is seen, no new request is enqueued, and the caller's
+ * destination pointer is instead recorded as a "fixup" against the
+ * canonical request.
+ *
+ * Because the weval tool only writes the canonical request's own
+ * destination, the fixups must be resolved at startup of the wevaled
+ * module: call `apply()` (e.g. first thing in `main()`), before any
+ * deduplicated destination is read, to copy the shared specialized
+ * function pointer into every duplicate's destination.
+ *
+ * Requests whose arguments use `SpecializeMemoryRef` or
+ * `SpecializeMemoryChunked` hash the buffer *pointers*, not their
+ * contents, so equal buffers at distinct addresses are conservatively
+ * treated as distinct.
+ */
+struct DedupIndex {
+  struct Entry {
+    uint64_t hash;
+    weval_req_t* req;
+  };
+  struct Fixup {
+    /* The canonical request's destination... */
+    weval_func_t* src;
+    /* ...copied into the duplicate's destination by `apply()`. */
+    weval_func_t* dest;
+  };
+
+  Entry* entries;
+  size_t cap;
+  size_t count;
+  Fixup* fixups;
+  size_t fixup_count;
+  size_t fixup_cap;
+
+  DedupIndex()
+      : entries(nullptr),
+        cap(0),
+        count(0),
+        fixups(nullptr),
+        fixup_count(0),
+        fixup_cap(0) {}
+
+  static uint64_t hash_req(const weval_req_t* req) {
+    uint64_t h = impl::kFnv1a64OffsetBasis;
+    uintptr_t func = reinterpret_cast<uintptr_t>(req->func);
+    h = impl::fnv1a_64(&func, sizeof(func), h);
+    h = impl::fnv1a_64(&req->user_id, sizeof(req->user_id), h);
+    h = impl::fnv1a_64(&req->num_globals, sizeof(req->num_globals), h);
+    h = impl::fnv1a_64(req->argbuf, req->arglen, h);
+    return h;
+  }
+
+  static bool equal(const weval_req_t* a, const weval_req_t* b) {
+    return a->func == b->func && a->user_id == b->user_id &&
+           a->num_globals == b->num_globals && a->arglen == b->arglen &&
+           memcmp(a->argbuf, b->argbuf, a->arglen) == 0;
+  }
+
+  bool grow() {
+    size_t new_cap = cap ? cap * 2 : 64;
+    Entry* new_entries =
+        reinterpret_cast<Entry*>(calloc(new_cap, sizeof(Entry)));
+    if (!new_entries) {
+      return false;
+    }
+    for (size_t i = 0; i < cap; i++) {
+      if (!entries[i].req) {
+        continue;
+      }
+      size_t slot = entries[i].hash & (new_cap - 1);
+      while (new_entries[slot].req) {
+        slot = (slot + 1) & (new_cap - 1);
+      }
+      new_entries[slot] = entries[i];
+    }
+    ::free(entries);
+    entries = new_entries;
+    cap = new_cap;
+    return true;
+  }
+
+  /* Returns the canonical request with content equal to `req`,
+   * inserting `req` itself as canonical if none exists yet. Returns
+   * null on allocation failure. */
+  weval_req_t* intern(weval_req_t* req) {
+    /* Grow at 3/4 load. */
+    if (count * 4 >= cap * 3 && !grow()) {
+      return nullptr;
+    }
+    uint64_t h = hash_req(req);
+    size_t slot = h & (cap - 1);
+    while (entries[slot].req) {
+      if (entries[slot].hash == h && equal(entries[slot].req, req)) {
+        return entries[slot].req;
+      }
+      slot = (slot + 1) & (cap - 1);
+    }
+    entries[slot].hash = h;
+    entries[slot].req = req;
+    count++;
+    return req;
+  }
+
+  bool record_fixup(weval_func_t* src, weval_func_t* dest) {
+    if (fixup_count == fixup_cap) {
+      size_t new_cap = fixup_cap ? fixup_cap * 2 : 16;
+      Fixup* new_fixups =
+          reinterpret_cast<Fixup*>(realloc(fixups, new_cap * sizeof(Fixup)));
+      if (!new_fixups) {
+        return false;
+      }
+      fixups = new_fixups;
+      fixup_cap = new_cap;
+    }
+    fixups[fixup_count].src = src;
+    fixups[fixup_count].dest = dest;
+    fixup_count++;
+    return true;
+  }
+
+  /* Copy each canonical request's specialized function pointer into
+   * the destinations of its deduplicated duplicates. Call once at
+   * startup of the wevaled module, before the destinations are first
+   * read. */
+  void apply() {
+    for (size_t i = 0; i < fixup_count; i++) {
+      *fixups[i].dest = *fixups[i].src;
+    }
+  }
+};
+
+/* As `weval()`, but consults `dedup`: if a request with identical
+ * content has already been registered through this index, no new
+ * request is enqueued; `dest` is instead recorded so that
+ * `dedup->apply()` fills it from the shared result. Returns the
+ * canonical request. */
+template <typename Ret, typename... Args, typename... WrappedArgs>
+weval_req_t* weval(DedupIndex* dedup, impl::FuncPtr<Ret, Args...>* dest,
+                   impl::FuncPtr<Ret, Args...> generic, uint32_t func_id,
+                   uint32_t num_globals, WrappedArgs... args) {
+  weval_req_t* req = impl::build_request(nullptr, dest, generic, func_id,
+                                         num_globals, args...);
+  if (!req) {
+    return nullptr;
+  }
+  weval_req_t* canonical = dedup->intern(req);
+  if (canonical && canonical != req &&
+      dedup->record_fixup(canonical->specialized, (weval_func_t*)dest)) {
+    req->next = req->prev = nullptr;
+    weval_free(req);
+    return canonical;
+  }
+  /* New content, or the index could not grow: register normally. */
+  weval_request(req);
+  return req;
+}
+
+/*
+ * Batch builder for registering many specializations of one generic
+ * function. All request records and argbufs are carved out of a
+ * single arena, so appending a request is a bump-pointer operation
+ * and the accumulated batch lands contiguously in the snapshotted
+ * heap; `commit()` splices the whole batch into the pending list with
+ * one list operation instead of one per request.
+ *
+ * The arena's storage intentionally outlives the builder: the pending
+ * requests point into it and must survive until the weval tool
+ * consumes them at snapshot time. Only call `weval_arena_free()` on
+ * `arena` once every request in the batch has been freed or
+ * satisfied.
+ */
+template <typename Ret, typename... Args>
+struct Batch {
+  weval_req_arena_t arena;
+  weval_req_t* head;
+  weval_req_t* tail;
+  /* Pending `weval_stats` contributions, accumulated in `add()` and
+   * credited (as registered or dropped) when `commit()` resolves the
+   * batch's fate. */
+  uint64_t count;
+  uint64_t argbuf_bytes;
+
+  Batch() : head(nullptr), tail(nullptr), count(0), argbuf_bytes(0) {
+    weval_arena_init(&arena, 0);
+  }
+  explicit Batch(size_t chunk_size)
+      : head(nullptr), tail(nullptr), count(0), argbuf_bytes(0) {
+    weval_arena_init(&arena, chunk_size);
+  }
+
+  template <typename... WrappedArgs>
+  weval_req_t* add(impl::FuncPtr<Ret, Args...>* dest,
+                   impl::FuncPtr<Ret, Args...> generic, uint32_t func_id,
+                   uint32_t num_globals, WrappedArgs... args) {
+    weval_req_t* req = impl::build_request(&arena, dest, generic, func_id,
+                                           num_globals, args...);
+    if (!req) {
+      return nullptr;
+    }
+    req->next = nullptr;
+    req->prev = tail;
+    if (tail) {
+      tail->next = req;
+    } else {
+      head = req;
+    }
+    tail = req;
+    count++;
+    argbuf_bytes += req->arglen;
+    return req;
+  }
+
+  /* Splice the accumulated requests onto the pending list. */
+  void commit() {
+    if (!head || (weval_is_wevaled && !weval_reweval_enabled)) {
+      weval_stats_add(&weval_stats.requests_dropped, count);
+      head = tail = nullptr;
+      count = 0;
+      argbuf_bytes = 0;
+      return;
+    }
+#if defined(__wasm_atomics__)
+    /* Mirror the lock-free push in `weval_request()`: claim the head
+     * by CAS -- with the whole batch at once -- and then write the
+     * displaced head's `prev` as the (single) displacer, so the
+     * splice is safe against concurrent `weval_request()` pushes. */
+    weval_req_t* old_head =
+        __atomic_load_n(&weval_req_pending_head, __ATOMIC_RELAXED);
+    do {
+      tail->next = old_head;
+    } while (!__atomic_compare_exchange_n(&weval_req_pending_head, &old_head,
+                                          head, /* weak = */ true,
+                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+    if (old_head) {
+      __atomic_store_n(&old_head->prev, tail, __ATOMIC_RELAXED);
+    }
+#else
+    tail->next = weval_req_pending_head;
+    if (weval_req_pending_head) {
+      weval_req_pending_head->prev = tail;
+    }
+    weval_req_pending_head = head;
+#endif
+    weval_stats_add(&weval_stats.requests_registered, count);
+    weval_stats_add(&weval_stats.argbuf_bytes, argbuf_bytes);
+    head = tail = nullptr;
+    count = 0;
+    argbuf_bytes = 0;
+  }
+};
+
 }  // namespace weval
 
 #endif  // __cplusplus
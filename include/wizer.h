@@ -119,6 +119,45 @@
     }                                                                          \
   }
 
+/*
+ * This macro is like `WIZER_INIT()`, but splits initialization into two
+ * phases, each with its own snapshot point. This is useful when
+ * initialization has an expensive, stable phase (engine and stdlib setup)
+ * and a cheap, frequently-changing phase (per-deployment configuration):
+ * the phase-1 snapshot can be built and cached once, and only phase 2
+ * re-run when the configuration changes.
+ *
+ * Phase 1 runs global constructors and then `phase1_func` under the
+ * standard `wizer-initialize` entry point; phase 2 runs `phase2_func`
+ * alone under a `wizer-initialize-phase2` entry point, on the module
+ * snapshotted by phase 1 (constructors are not re-run). With the weval
+ * tool, the flow is two invocations:
+ *
+ *     $ weval weval -w --cache app.cache -i in.wasm -o stable.wasm
+ *     $ weval weval -w --init-func wizer-initialize-phase2 \
+ *           --cache app.cache -i stable.wasm -o out.wasm
+ *
+ * `stable.wasm` (and the weval cache keyed on it) is reusable across
+ * deployments; only the second, fast invocation runs per deploy.
+ *
+ * Caveats: the first invocation's weval pass filters out the weval
+ * intrinsic imports, so weval requests registered during phase 2 must
+ * opt into the re-weval flow (see `weval_enable_reweval()` in weval.h,
+ * including its note on post-filter intrinsic behavior). Phase 2 runs
+ * against the snapshotted heap, so it must not assume a fresh memory
+ * image.
+ */
+#define WIZER_INIT_PHASES(phase1_func, phase2_func)                            \
+  /* Phase-2 entry point, invoked by a second pre-initialization pass   */     \
+  /* (`--init-func wizer-initialize-phase2`). Global constructors       */     \
+  /* already ran during the phase-1 snapshot, so only the phase         */     \
+  /* function runs here. */                                                    \
+  __attribute__((export_name("wizer-initialize-phase2"))) void                 \
+  __wizer_initialize_phase2() {                                                \
+    phase2_func();                                                             \
+  }                                                                            \
+  WIZER_INIT(phase1_func)
+
 /*
  * This macro is like `WIZER_INIT()`, but takes no initialization function.
  * Instead, the pre-initialization phase only executes C++ global constructors
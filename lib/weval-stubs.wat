@@ -11,14 +11,40 @@
  (func (export "read.reg") (param i64) (result i64)
        unreachable)
  (func (export "write.reg") (param i64 i64))
+ (func (export "read.regs") (param i64 i32 i32)
+       unreachable)
+ (func (export "write.regs") (param i64 i32 i32))
  (func (export "trace.line") (param i32))
+ (func (export "trace.flush") (param i32 i32))
  (func (export "abort.specialization") (param i32 i32))
  (func (export "assert.const32") (param i32 i32))
  (func (export "assert.const.memory") (param i32 i32))
+ (func (export "assume.range") (param i32 i32 i32) (result i32)
+ local.get 0)
+ (func (export "assume.range64") (param i64 i64 i64) (result i64)
+ local.get 0)
+ (func (export "assume.unreachable")
+ unreachable)
+ (func (export "hint.cold"))
+ (func (export "expect32") (param i32 i32) (result i32)
+ local.get 0)
  (func (export "specialize.value") (param i32 i32 i32) (result i32)
  local.get 0)
+ (func (export "specialize.value64") (param i64 i64 i64) (result i64)
+ local.get 0)
+ (func (export "specialize.value64.masked") (param i64 i64 i64 i64) (result i64)
+       local.get 0
+       local.get 1
+       i64.and
+       local.get 1
+       i64.ctz
+       i64.shr_u)
+ (func (export "specialize.cached") (param i32 i32 i32) (result i32)
+ local.get 0)
  (func (export "print") (param i32 i32 i32))
+ (func (export "context.name") (param i32))
  (func (export "read.specialization.global") (param i32) (result i64) unreachable)
+ (func (export "read.specialization.globals") (param i32 i32 i32) unreachable)
  (func (export "push.stack") (param i32 i64))
  (func (export "sync.stack"))
  (func (export "read.stack") (param i32 i32) (result i64)
@@ -26,9 +52,17 @@
  (func (export "write.stack") (param i32 i32 i64))
  (func (export "pop.stack") (param i32) (result i64)
        unreachable)
+ (func (export "pushn.stack") (param i32 i32 i32))
+ (func (export "popn.stack") (param i32 i32 i32)
+       unreachable)
+ (func (export "readn.stack") (param i32 i32 i32)
+       unreachable)
+ (func (export "sync.stack.partial") (param i32))
  (func (export "read.local") (param i32 i32) (result i64)
        unreachable)
  (func (export "write.local") (param i32 i32 i64))
+ (func (export "promote.frame") (param i32 i32) (result i32)
+       local.get 0)
  (func (export "read.global.0") (result i64)
        global.get $g0)
  (func (export "write.global.0") (param i64)
@@ -118,14 +118,20 @@ impl Cache {
 }
 
 impl<'a> CacheThreadCtx<'a> {
+    /// Looks up a cached result. All entries -- including
+    /// content-hash-keyed ones (see `Directive::cache_key`) -- are
+    /// scoped to this module's hash: the cached payload is compiled
+    /// code that embeds this module's function and signature index
+    /// assignment, so it must never be served to a different module.
     pub fn lookup(&mut self, key: &[u8]) -> anyhow::Result<Option<CacheData>> {
+        let module_hash = &self.cache.module_hash[..];
         let mut result = None;
         for lookup in self
             .ro_lookup_stmt
             .iter_mut()
             .chain(self.lookup_stmt.iter_mut())
         {
-            lookup.bind((1, &self.cache.module_hash[..]))?;
+            lookup.bind((1, module_hash))?;
             lookup.bind((2, key))?;
 
             while lookup.next()? == sqlite::State::Row {
@@ -142,9 +148,10 @@ impl<'a> CacheThreadCtx<'a> {
     }
 
     pub fn insert(&mut self, key: &[u8], data: CacheData) -> anyhow::Result<()> {
+        let module_hash = &self.cache.module_hash[..];
         if let Some(insert) = self.insert_stmt.as_mut() {
             let data = bincode::serialize(&data)?;
-            insert.bind((1, &self.cache.module_hash[..]))?;
+            insert.bind((1, module_hash))?;
             insert.bind((2, key))?;
             insert.bind((3, &data[..]))?;
             while insert.next()? == sqlite::State::Row {}
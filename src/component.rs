@@ -14,6 +14,8 @@ pub(crate) struct Opts {
     pub(crate) cache_ro: Option<PathBuf>,
     pub(crate) show_stats: bool,
     pub(crate) output_ir: Option<PathBuf>,
+    pub(crate) profile_out: Option<PathBuf>,
+    pub(crate) max_specializations: Option<usize>,
     pub(crate) verbose: bool,
 }
 
@@ -150,6 +152,9 @@ pub(crate) fn weval(component_bytes: &[u8], opts: Opts) -> anyhow::Result<Vec<u8
                         .output_ir
                         .as_ref()
                         .map(|dir| dir.join(format!("core-module-{core_module_index}")));
+                    let profile_out = opts.profile_out.as_ref().map(|path| {
+                        path.with_extension(format!("core-module-{core_module_index}"))
+                    });
 
                     crate::module::weval(
                         module_bytes,
@@ -159,6 +164,8 @@ pub(crate) fn weval(component_bytes: &[u8], opts: Opts) -> anyhow::Result<Vec<u8
                             module_hash: cache::compute_hash(module_bytes),
                             show_stats: opts.show_stats,
                             output_ir,
+                            profile_out,
+                            max_specializations: opts.max_specializations,
                             verbose: opts.verbose,
                         },
                     )?
@@ -16,12 +16,49 @@ pub(crate) struct Directive {
     pub func: Func,
     /// Evaluate with the given arguments, encoded as a bytestring.
     pub args: Vec<u8>,
+    /// Whether `args` uses the packed (v2) encoding
+    /// (`WEVAL_REQ_FLAG_ARGS_V2` in `include/weval.h`) rather than
+    /// the legacy array of 16-byte records. Part of the cache key:
+    /// the same bytes mean different arguments under the two
+    /// encodings.
+    pub args_packed: bool,
     /// The number of globals prepended to the `args` list.
     pub num_globals: u32,
     /// Place the ID of the resulting specialized function at the
     /// given address in memory, if nonzero.
     #[serde(skip)]
     pub func_index_out_addr: u32,
+    /// Process this directive before lower-priority ones; the lowest
+    /// priorities are dropped first under a specialization budget.
+    /// Not part of the cache key: it does not affect the specialized
+    /// code.
+    #[serde(skip)]
+    pub priority: u32,
+    /// Guest-supplied stable identity of this request (0 if absent);
+    /// see `weval::set_content_hash()` in `include/weval.h`. Not
+    /// serialized with the rest of the directive: when present it
+    /// *replaces* the default cache key (see `cache_key`).
+    #[serde(skip)]
+    pub content_hash: u64,
+}
+
+impl Directive {
+    /// Cache key for this directive's compiled body. By default this
+    /// is the serialized directive, but with a guest-supplied content
+    /// hash we key on that instead: the raw argbuf bytes embed heap
+    /// pointers that can differ between runs (and registration
+    /// orders) even when the request is semantically unchanged, which
+    /// defeats the default key. Either way the cache scopes entries
+    /// to the input module's hash (see `CacheThreadCtx::lookup`): the
+    /// cached payload embeds module-relative indices and is never
+    /// valid for a different module.
+    pub(crate) fn cache_key(&self) -> Vec<u8> {
+        if self.content_hash != 0 {
+            bincode::serialize(&("content-hash", self.user_id, self.content_hash)).unwrap()
+        } else {
+            bincode::serialize(self).unwrap()
+        }
+    }
 }
 
 #[derive(Clone, Debug)]
@@ -40,9 +77,18 @@ pub(crate) struct DirectiveArgs {
 pub(crate) struct MemoryBuffer {
     /// The bytes in memory at this pointer.
     data: Arc<Vec<u8>>,
+    /// Whether this buffer was given as chunked segments: the
+    /// wasm-level argument is then a pointer to the segment table
+    /// rather than to these (concatenated) contents, so the pointer
+    /// must never escape into the specialized body.
+    chunked: bool,
 }
 
 impl MemoryBuffer {
+    pub(crate) fn is_chunked(&self) -> bool {
+        self.chunked
+    }
+
     pub(crate) fn read_size(&self, offset: u32, size: u32) -> anyhow::Result<u64> {
         let offset = usize::try_from(offset).unwrap();
         let size = usize::try_from(size).unwrap();
@@ -100,9 +146,42 @@ pub(crate) fn collect(module: &Module, im: &mut Image) -> anyhow::Result<Vec<Dir
         head = next;
     }
 
+    // Requests may also arrive in the contiguous pending table: a
+    // (entries, len, cap) triple of 32-bit words, with `len` by-value
+    // request records laid out sequentially at `entries`.
+    if let Some(table_addr) = find_global_data_by_exported_func(module, "weval.pending.table") {
+        let entries = im.read_u32(heap, table_addr)?;
+        let len = im.read_u32(heap, table_addr + 4)?;
+        for i in 0..len {
+            directives.push(decode_weval_req(im, heap, entries + i * WEVAL_REQ_SIZE)?);
+        }
+        // Mark the table consumed, so that a subsequent weval of the
+        // output module only sees newly-appended entries.
+        im.write_u32(heap, table_addr + 4, 0)?;
+    }
+
     Ok(directives)
 }
 
+/// Size of a `weval_req_t` record; used as the stride of the pending
+/// table. Keep in sync with the struct definition in
+/// `include/weval.h` (and the field offsets in `decode_weval_req`).
+const WEVAL_REQ_SIZE: u32 = 48;
+
+/// Flag bit on `weval_req_t::flags`: the request record/argbuf are
+/// arena-allocated. A guest-side allocation detail, but part of the
+/// known-bits mask below. Keep in sync with `include/weval.h`.
+const WEVAL_REQ_FLAG_ARENA: u32 = 1;
+
+/// Flag bit on `weval_req_t::flags`: the argbuf uses the packed (v2)
+/// argument encoding. Keep in sync with `include/weval.h`.
+const WEVAL_REQ_FLAG_ARGS_V2: u32 = 2;
+
+/// Flag bit on `weval_req_t::flags`: the `content_hash` field is
+/// present and was stamped by the guest. Keep in sync with
+/// `include/weval.h`.
+const WEVAL_REQ_FLAG_CONTENT_HASH: u32 = 4;
+
 fn decode_weval_req(im: &Image, heap: Memory, head: u32) -> anyhow::Result<Directive> {
     // Keep these offsets in sync with the struct definition in
     // `include/weval.h`.
@@ -113,22 +192,49 @@ fn decode_weval_req(im: &Image, heap: Memory, head: u32) -> anyhow::Result<Direc
     let arg_ptr = im.read_u32(heap, head + 20)?;
     let arg_len = im.read_u32(heap, head + 24)?;
     let func_index_out_addr = im.read_u32(heap, head + 28)?;
+    // Offset 32 holds flag bits. A guest built against an older
+    // header allocates a shorter record, so anything past the fields
+    // it knows about is heap garbage; only honor optional flags (and
+    // the fields they gate) when the flags word contains no unknown
+    // bits.
+    let flags = im.read_u32(heap, head + 32)?;
+    let flags_valid =
+        flags & !(WEVAL_REQ_FLAG_ARENA | WEVAL_REQ_FLAG_ARGS_V2 | WEVAL_REQ_FLAG_CONTENT_HASH) == 0;
+    let args_packed = flags_valid && flags & WEVAL_REQ_FLAG_ARGS_V2 != 0;
+    let priority = im.read_u32(heap, head + 36)?;
+    let content_hash = if flags_valid && flags & WEVAL_REQ_FLAG_CONTENT_HASH != 0 {
+        im.read_u64(heap, head + 40)?
+    } else {
+        0
+    };
     let args = im.read_slice(heap, arg_ptr, arg_len)?.to_vec();
 
-    log::trace!("directive: args {arg_ptr:#x} len {arg_len:#x}");
+    log::trace!("directive: args {arg_ptr:#x} len {arg_len:#x} packed {args_packed}");
 
     Ok(Directive {
         user_id,
         num_globals,
         func,
         args,
+        args_packed,
         func_index_out_addr,
+        priority,
+        content_hash,
     })
 }
 
 impl DirectiveArgs {
-    /// Decode an argument-request bytestring.
-    pub(crate) fn decode(bytes: &[u8]) -> anyhow::Result<DirectiveArgs> {
+    /// Decode an argument-request bytestring. By-reference buffer
+    /// args refer to the live heap, so we need the memory image too.
+    pub(crate) fn decode(
+        im: &Image,
+        heap: Memory,
+        bytes: &[u8],
+        packed: bool,
+    ) -> anyhow::Result<DirectiveArgs> {
+        if packed {
+            return DirectiveArgs::decode_packed(im, heap, bytes);
+        }
         let mut const_params = vec![];
         let mut const_memory = vec![];
         let mut arg_ptr = 0;
@@ -188,6 +294,7 @@ impl DirectiveArgs {
                                 bytes[arg_ptr + 16..(arg_ptr + 16 + usize::try_from(len).unwrap())]
                                     .to_vec(),
                             ),
+                            chunked: false,
                         };
                         (
                             AbstractValue::ConcreteMemory(MemoryBufferIndex(i), 0),
@@ -195,6 +302,44 @@ impl DirectiveArgs {
                             16 + padded_len,
                         )
                     }
+                    5 => {
+                        // By-reference buffer: pointer and length
+                        // into the snapshotted heap; no inline data.
+                        let ptr = read_u32(arg_ptr + 8);
+                        let len = read_u32(arg_ptr + 12);
+                        let data = MemoryBuffer {
+                            data: Arc::new(im.read_slice(heap, ptr, len)?.to_vec()),
+                            chunked: false,
+                        };
+                        (
+                            AbstractValue::ConcreteMemory(MemoryBufferIndex(i), 0),
+                            Some(data),
+                            16,
+                        )
+                    }
+                    6 => {
+                        // Chunked buffer: pointer to an array of
+                        // (ptr, len) segment records in the
+                        // snapshotted heap, logically concatenated
+                        // into one constant buffer.
+                        let segs = read_u32(arg_ptr + 8);
+                        let count = read_u32(arg_ptr + 12);
+                        let mut concat = vec![];
+                        for j in 0..count {
+                            let seg_ptr = im.read_u32(heap, segs + 8 * j)?;
+                            let seg_len = im.read_u32(heap, segs + 8 * j + 4)?;
+                            concat.extend_from_slice(im.read_slice(heap, seg_ptr, seg_len)?);
+                        }
+                        let data = MemoryBuffer {
+                            data: Arc::new(concat),
+                            chunked: true,
+                        };
+                        (
+                            AbstractValue::ConcreteMemory(MemoryBufferIndex(i), 0),
+                            Some(data),
+                            16,
+                        )
+                    }
                     _ => anyhow::bail!("Invalid type: {ty}"),
                 }
             } else {
@@ -211,4 +356,135 @@ impl DirectiveArgs {
             const_memory,
         })
     }
+
+    /// Decode the packed (v2) argument encoding: one tag byte per
+    /// argument (a `weval_req_arg_type` value, or 255 for a runtime
+    /// arg), a 4-byte slot for i32/f32 and an 8-byte slot for
+    /// i64/f64, and ULEB128 buffer lengths/pointers with no alignment
+    /// padding. Keep in sync with the writers in `include/weval.h`.
+    fn decode_packed(im: &Image, heap: Memory, bytes: &[u8]) -> anyhow::Result<DirectiveArgs> {
+        let mut const_params = vec![];
+        let mut const_memory = vec![];
+
+        // Pointer/length fields are up to 64 bits wide (the encoding
+        // is shared with wasm64 guests), though on wasm32 heaps the
+        // values must fit in 32 bits.
+        let read_uleb = |p: &mut usize| -> anyhow::Result<u64> {
+            let mut result: u64 = 0;
+            let mut shift = 0;
+            loop {
+                let byte = *bytes
+                    .get(*p)
+                    .ok_or_else(|| anyhow::anyhow!("Truncated packed argbuf"))?;
+                *p += 1;
+                anyhow::ensure!(shift < 64, "Overlong ULEB128 in packed argbuf");
+                result |= u64::from(byte & 0x7f) << shift;
+                if byte & 0x80 == 0 {
+                    return Ok(result);
+                }
+                shift += 7;
+            }
+        };
+        let read_bytes = |p: &mut usize, len: usize| -> anyhow::Result<&[u8]> {
+            let slice = bytes
+                .get(*p..(*p + len))
+                .ok_or_else(|| anyhow::anyhow!("Truncated packed argbuf"))?;
+            *p += len;
+            Ok(slice)
+        };
+        let read_u32 = |p: &mut usize| -> anyhow::Result<u32> {
+            let slice = read_bytes(p, 4)?;
+            Ok(u32::from_le_bytes([slice[0], slice[1], slice[2], slice[3]]))
+        };
+        let read_u64 = |p: &mut usize| -> anyhow::Result<u64> {
+            let slice = read_bytes(p, 8)?;
+            Ok(u64::from_le_bytes([
+                slice[0], slice[1], slice[2], slice[3], slice[4], slice[5], slice[6], slice[7],
+            ]))
+        };
+
+        let mut p = 0;
+        let mut i = 0;
+        while p < bytes.len() {
+            let tag = bytes[p];
+            p += 1;
+            let (value, mem) = match u32::from(tag) {
+                0 => (
+                    AbstractValue::Concrete(WasmVal::I32(read_u32(&mut p)?)),
+                    None,
+                ),
+                1 => (
+                    AbstractValue::Concrete(WasmVal::I64(read_u64(&mut p)?)),
+                    None,
+                ),
+                2 => (
+                    AbstractValue::Concrete(WasmVal::F32(read_u32(&mut p)?)),
+                    None,
+                ),
+                3 => (
+                    AbstractValue::Concrete(WasmVal::F64(read_u64(&mut p)?)),
+                    None,
+                ),
+                4 => {
+                    let len = read_uleb(&mut p)?;
+                    let data = MemoryBuffer {
+                        data: Arc::new(read_bytes(&mut p, usize::try_from(len).unwrap())?.to_vec()),
+                        chunked: false,
+                    };
+                    (
+                        AbstractValue::ConcreteMemory(MemoryBufferIndex(i), 0),
+                        Some(data),
+                    )
+                }
+                5 => {
+                    let ptr = u32::try_from(read_uleb(&mut p)?)
+                        .map_err(|_| anyhow::anyhow!("Buffer pointer beyond 32-bit heap"))?;
+                    let len = u32::try_from(read_uleb(&mut p)?)
+                        .map_err(|_| anyhow::anyhow!("Buffer length beyond 32-bit heap"))?;
+                    let data = MemoryBuffer {
+                        data: Arc::new(im.read_slice(heap, ptr, len)?.to_vec()),
+                        chunked: false,
+                    };
+                    (
+                        AbstractValue::ConcreteMemory(MemoryBufferIndex(i), 0),
+                        Some(data),
+                    )
+                }
+                6 => {
+                    // Chunked buffer: a segment count, then a
+                    // (ptr, len) pair per segment, each referring to
+                    // the snapshotted heap; the segments are
+                    // logically concatenated into one constant
+                    // buffer.
+                    let count = read_uleb(&mut p)?;
+                    let mut concat = vec![];
+                    for _ in 0..count {
+                        let ptr = u32::try_from(read_uleb(&mut p)?)
+                            .map_err(|_| anyhow::anyhow!("Buffer pointer beyond 32-bit heap"))?;
+                        let len = u32::try_from(read_uleb(&mut p)?)
+                            .map_err(|_| anyhow::anyhow!("Buffer length beyond 32-bit heap"))?;
+                        concat.extend_from_slice(im.read_slice(heap, ptr, len)?);
+                    }
+                    let data = MemoryBuffer {
+                        data: Arc::new(concat),
+                        chunked: true,
+                    };
+                    (
+                        AbstractValue::ConcreteMemory(MemoryBufferIndex(i), 0),
+                        Some(data),
+                    )
+                }
+                255 => (AbstractValue::Runtime(None), None),
+                ty => anyhow::bail!("Invalid type: {ty}"),
+            };
+            const_params.push(value);
+            const_memory.push(mem);
+            i += 1;
+        }
+
+        Ok(DirectiveArgs {
+            const_params,
+            const_memory,
+        })
+    }
 }
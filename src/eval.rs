@@ -6,13 +6,13 @@ use crate::image::Image;
 use crate::intrinsics::{find_global_data_by_exported_func, Intrinsics};
 use crate::liveness::Liveness;
 use crate::state::*;
-use crate::stats::SpecializationStats;
+use crate::stats::{ContextProfile, SpecializationProfile, SpecializationStats};
 use crate::value::{AbstractValue, WasmVal};
 use fxhash::FxHashMap as HashMap;
 use fxhash::FxHashSet as HashSet;
 use rayon::prelude::*;
 use std::borrow::Cow;
-use std::collections::{hash_map::Entry as HashEntry, BTreeSet, VecDeque};
+use std::collections::{hash_map::Entry as HashEntry, BTreeMap, BTreeSet, VecDeque};
 use std::sync::Mutex;
 use waffle::{
     cfg::CFGInfo, entity::EntityRef, entity::PerEntity, pool::ListRef, Block, BlockDef,
@@ -58,6 +58,17 @@ struct Evaluator<'a> {
     queue: VecDeque<(Block, Context, Block)>,
     /// Set to deduplicate `queue`.
     queue_set: HashSet<(Block, Context)>,
+    /// Intermediate blocks synthesized for inline-cache
+    /// (`specialize.cached`) compare-and-branch chains. Not in
+    /// `block_map` (they correspond to no generic block), but they
+    /// carry flow state and need stack syncs like any other pred of a
+    /// specialized block.
+    chain_blocks: Vec<Block>,
+    /// Byte size of the frame declared private via
+    /// `weval_promote_frame()`, if any. Plain 8-byte loads and stores
+    /// whose address is a constant offset into the frame are
+    /// virtualized into `ProgPointState::frame_slots`.
+    frame_size: Option<u32>,
     /// Stats accumulated during specialization.
     stats: SpecializationStats,
 }
@@ -66,6 +77,8 @@ pub(crate) struct PartialEvalResult<'a> {
     pub module: Module<'a>,
     pub global_base: usize,
     pub stats: Vec<SpecializationStats>,
+    /// Per-directive context profiles (cache hits are not profiled).
+    pub profiles: Vec<SpecializationProfile>,
 }
 
 /// Partially evaluates according to the given directives. Returns
@@ -77,15 +90,35 @@ pub(crate) fn partially_evaluate<'a>(
     mut progress: Option<indicatif::ProgressBar>,
     output_ir: Option<std::path::PathBuf>,
     cache: &Cache,
+    max_specializations: Option<usize>,
 ) -> anyhow::Result<PartialEvalResult<'a>> {
     let intrinsics = Intrinsics::find(&module);
     log::trace!("intrinsics: {intrinsics:?}");
 
+    // Total directives seen, for the guest's stats block below.
+    let requests_processed = directives.len() as u64;
+
     // Sort directives by out-address, and remove duplicates.
     let mut directives = directives.to_vec();
     directives.sort_by_key(|d| d.func_index_out_addr);
     directives.dedup_by_key(|d| d.func_index_out_addr);
 
+    // Process in descending priority order; under a specialization
+    // budget, drop the lowest-priority directives entirely. Their
+    // destinations are left untouched, so the affected call sites
+    // keep dispatching to the generic functions.
+    directives.sort_by_key(|d| std::cmp::Reverse(d.priority));
+    if let Some(max) = max_specializations {
+        if directives.len() > max {
+            log::info!(
+                "specialization budget: dropping {} of {} directives",
+                directives.len() - max,
+                directives.len()
+            );
+            directives.truncate(max);
+        }
+    }
+
     if let Some(p) = progress.as_mut() {
         p.set_length(directives.len() as u64);
     }
@@ -97,7 +130,7 @@ pub(crate) fn partially_evaluate<'a>(
     let mut cache_ctx = cache.thread()?;
     let mut remaining_directives = vec![];
     for directive in directives {
-        let key = bincode::serialize(&directive).unwrap();
+        let key = directive.cache_key();
         if let Some(data) = cache_ctx.lookup(&key)? {
             bodies.push((
                 Cow::Owned(directive),
@@ -156,6 +189,7 @@ pub(crate) fn partially_evaluate<'a>(
 
     let global_base = module.globals.len();
 
+    let profiles = Mutex::new(vec![]);
     let progress_ref = progress.as_ref();
     bodies.extend(
         directives
@@ -180,8 +214,9 @@ pub(crate) fn partially_evaluate<'a>(
                 if let Some(p) = progress_ref {
                     p.inc(1);
                 }
-                if let Some((body, sig, name, spec_stats)) = result {
+                if let Some((body, sig, name, spec_stats, profile)) = result {
                     stats.lock().unwrap().add_specialization(&spec_stats);
+                    profiles.lock().unwrap().push(profile);
                     let ir = if output_ir.is_some() {
                         use std::fmt::Write;
                         let cfg = CFGInfo::new(&body);
@@ -224,11 +259,12 @@ pub(crate) fn partially_evaluate<'a>(
     }
 
     // Compute memory updates.
+    let requests_satisfied = bodies.len() as u64;
     let mut mem_updates = HashMap::default();
     for (directive, decl, ir, cache_hit) in bodies {
         // Add to cache.
         if !cache_hit && cache.can_insert() {
-            let key = bincode::serialize(&directive)?;
+            let key = directive.cache_key();
             let (sig, name, body) = match &decl {
                 FuncDecl::Compiled(sig, name, body) => (sig, name, body),
                 _ => unreachable!(),
@@ -280,16 +316,33 @@ pub(crate) fn partially_evaluate<'a>(
         im.write_u32(heap, is_wevaled, 1)?;
     }
 
+    // Fill in the tool-side fields of the guest's stats block, if it
+    // exists and is exported: how many directives we saw, and how
+    // many produced a specialized function (cache hits included).
+    // Field offsets match `weval_stats_t` in `include/weval.h`.
+    if let Some(stats_addr) = find_global_data_by_exported_func(&module, "weval.stats") {
+        log::info!(
+            "updating stats block at {stats_addr:#x}: {requests_satisfied} of \
+             {requests_processed} requests satisfied"
+        );
+        im.write_u64(heap, stats_addr + 32, requests_processed)?;
+        im.write_u64(heap, stats_addr + 40, requests_satisfied)?;
+    }
+
     let mut stats = funcs
         .drain()
         .map(|(_, (_, _, stats))| stats.into_inner().unwrap())
         .collect::<Vec<_>>();
     stats.sort_by_key(|stats| stats.generic);
 
+    let mut profiles = profiles.into_inner().unwrap();
+    profiles.sort_by_key(|profile| (profile.generic, profile.user_id));
+
     Ok(PartialEvalResult {
         module,
         global_base,
         stats,
+        profiles,
     })
 }
 
@@ -300,8 +353,22 @@ fn partially_evaluate_func(
     image: &Image,
     intrinsics: &Intrinsics,
     directive: &Directive,
-) -> anyhow::Result<Option<(FunctionBody, Signature, String, SpecializationStats)>> {
-    let directive_args = DirectiveArgs::decode(&directive.args[..])?;
+) -> anyhow::Result<
+    Option<(
+        FunctionBody,
+        Signature,
+        String,
+        SpecializationStats,
+        SpecializationProfile,
+    )>,
+> {
+    let start = std::time::Instant::now();
+    let directive_args = DirectiveArgs::decode(
+        image,
+        image.main_heap()?,
+        &directive.args[..],
+        directive.args_packed,
+    )?;
     let orig_name = module.funcs[directive.func].name();
     let sig = module.funcs[directive.func].sig();
 
@@ -328,6 +395,8 @@ fn partially_evaluate_func(
         reg_map: HashMap::default(),
         queue: VecDeque::new(),
         queue_set: HashSet::default(),
+        chain_blocks: vec![],
+        frame_size: None,
         stats: SpecializationStats::default(),
     };
     let (ctx, entry_state) = evaluator.state.init(image);
@@ -373,12 +442,14 @@ fn partially_evaluate_func(
 
     accumulate_stats_from_func(&mut evaluator.stats, &evaluator.func);
 
+    let profile = evaluator.build_profile(start.elapsed().as_micros());
+
     log::info!("Specialization of {directive:?} done");
     log::debug!(
         "Adding func:\n{}",
         evaluator.func.display_verbose("| ", Some(module))
     );
-    Ok(Some((evaluator.func, sig, name, evaluator.stats)))
+    Ok(Some((evaluator.func, sig, name, evaluator.stats, profile)))
 }
 
 // Split at every `weval_specialize_value()` call and
@@ -392,6 +463,9 @@ fn split_blocks_at_intrinsic_calls(func: &mut FunctionBody, intrinsics: &Intrins
             if let ValueDef::Operator(Operator::Call { function_index }, _, _) = &func.values[inst]
             {
                 if Some(*function_index) == intrinsics.specialize_value
+                    || Some(*function_index) == intrinsics.specialize_value64
+                    || Some(*function_index) == intrinsics.specialize_value64_masked
+                    || Some(*function_index) == intrinsics.specialize_cached
                     || Some(*function_index) == intrinsics.pop_context
                 {
                     log::trace!("Splitting from block {block} at weval intrinsic for inst {inst}");
@@ -440,6 +514,9 @@ fn find_cut_blocks(
                     || Some(*function_index) == intrinsics.push_context
                     || Some(*function_index) == intrinsics.pop_context
                     || Some(*function_index) == intrinsics.specialize_value
+                    || Some(*function_index) == intrinsics.specialize_value64
+                    || Some(*function_index) == intrinsics.specialize_value64_masked
+                    || Some(*function_index) == intrinsics.specialize_cached
                 {
                     change_ctx_blocks.insert(block);
                     continue 'blocks;
@@ -555,6 +632,76 @@ fn load_operator(ty: Type) -> Option<Operator> {
     }
 }
 
+/// Fold an unsigned comparison (or equality) between two assumed
+/// inclusive ranges `[xlo, xhi]` and `[ylo, yhi]`, if the ranges are
+/// conclusive either way. Signed comparisons are not folded: the
+/// ranges are unsigned, and an unsigned range may straddle the signed
+/// ordering.
+fn range_cmp(op: &Operator, xlo: u64, xhi: u64, ylo: u64, yhi: u64) -> Option<AbstractValue> {
+    let result = match op {
+        Operator::I32Eq | Operator::I64Eq => {
+            if xlo == xhi && ylo == yhi && xlo == ylo {
+                true
+            } else if xhi < ylo || xlo > yhi {
+                false
+            } else {
+                return None;
+            }
+        }
+        Operator::I32Ne | Operator::I64Ne => {
+            if xhi < ylo || xlo > yhi {
+                true
+            } else if xlo == xhi && ylo == yhi && xlo == ylo {
+                false
+            } else {
+                return None;
+            }
+        }
+        Operator::I32LtU | Operator::I64LtU => {
+            if xhi < ylo {
+                true
+            } else if xlo >= yhi {
+                false
+            } else {
+                return None;
+            }
+        }
+        Operator::I32LeU | Operator::I64LeU => {
+            if xhi <= ylo {
+                true
+            } else if xlo > yhi {
+                false
+            } else {
+                return None;
+            }
+        }
+        Operator::I32GtU | Operator::I64GtU => {
+            if xlo > yhi {
+                true
+            } else if xhi <= ylo {
+                false
+            } else {
+                return None;
+            }
+        }
+        Operator::I32GeU | Operator::I64GeU => {
+            if xlo >= yhi {
+                true
+            } else if xhi < ylo {
+                false
+            } else {
+                return None;
+            }
+        }
+        _ => return None,
+    };
+    Some(AbstractValue::Concrete(WasmVal::I32(if result {
+        1
+    } else {
+        0
+    })))
+}
+
 #[derive(Debug)]
 enum EvalResult {
     Unhandled,
@@ -611,6 +758,7 @@ impl<'a> Evaluator<'a> {
             context: ctx,
             pending_context: None,
             pending_specialize: None,
+            pending_specialize_cached: None,
             flow: self.state.block_entry[new_block].clone(),
         };
         log::trace!(" -> state = {state:?}");
@@ -876,6 +1024,55 @@ impl<'a> Evaluator<'a> {
         }
     }
 
+    /// Full description of a context chain, outermost first.
+    fn context_chain_desc(&self, mut ctx: Context) -> String {
+        let mut parts = vec![];
+        loop {
+            parts.push(self.context_desc(ctx));
+            match self.state.contexts.leaf_element(ctx) {
+                ContextElem::Root => break,
+                _ => ctx = self.state.contexts.parent(ctx),
+            }
+        }
+        parts.reverse();
+        parts.join(" / ")
+    }
+
+    /// Attribute the specialized output back to the contexts that
+    /// produced it, for the machine-readable profile.
+    fn build_profile(&self, micros: u128) -> SpecializationProfile {
+        let (_, _, reachable) = crate::stats::count_reachable_blocks_and_insts(&self.func);
+        let mut by_ctx: BTreeMap<Context, (usize, usize)> = BTreeMap::new();
+        for &block in &reachable {
+            let (ctx, _) = self.block_rev_map[block];
+            if ctx.is_invalid() {
+                // Synthetic block (e.g. the pre-entry): not
+                // attributable to any context.
+                continue;
+            }
+            let entry = by_ctx.entry(ctx).or_default();
+            entry.0 += 1;
+            entry.1 += self.func.blocks[block].insts.len();
+        }
+        let contexts = by_ctx
+            .into_iter()
+            .map(|(ctx, (blocks, insts))| ContextProfile {
+                desc: self.context_chain_desc(ctx),
+                name: self.state.contexts.context_name[ctx].clone(),
+                bucket: self.state.contexts.context_bucket[ctx],
+                cold: self.state.contexts.context_cold[ctx],
+                blocks,
+                insts,
+            })
+            .collect();
+        SpecializationProfile {
+            user_id: self.directive.user_id,
+            generic: self.directive.func,
+            micros,
+            contexts,
+        }
+    }
+
     fn create_block(
         &mut self,
         orig_block: Block,
@@ -999,10 +1196,10 @@ impl<'a> Evaluator<'a> {
         // Parallel-move semantics: read all uses above, then write
         // all defs below.
         let mut changed = false;
-        for (blockparam, (orig_arg, abs)) in self.generic.blocks[target.block]
+        for ((ty, blockparam), (orig_arg, abs)) in self.generic.blocks[target.block]
             .params
             .iter()
-            .map(|(_, val)| *val)
+            .map(|&(ty, val)| (ty, val))
             .zip(target.args.iter().zip(abs_args.iter()))
         {
             let orig_arg = self.generic.resolve_alias(*orig_arg);
@@ -1015,7 +1212,12 @@ impl<'a> Evaluator<'a> {
                     log::trace!(
                         "Specialized context into block {target_block} context {target_ctx}: index {index} becomes val {val} from generic {orig_arg}",
                     );
-                    AbstractValue::Concrete(WasmVal::I32(val))
+                    let val = match ty {
+                        Type::I32 => WasmVal::I32(val as u32),
+                        Type::I64 => WasmVal::I64(val),
+                        _ => panic!("Unsupported type {ty} for value specialization"),
+                    };
+                    AbstractValue::Concrete(val)
                 } else {
                     abs.clone()
                 }
@@ -1065,6 +1267,7 @@ impl<'a> Evaluator<'a> {
                 ref if_false,
             } => {
                 assert!(!state.pending_specialize.is_some());
+                assert!(!state.pending_specialize_cached.is_some());
                 let (cond, abs_cond) = self.use_value(state.context, orig_block, new_block, cond);
                 // Update pending context with new stack if necessary.
                 match abs_cond.as_const_truthy() {
@@ -1127,11 +1330,117 @@ impl<'a> Evaluator<'a> {
                         .collect();
                     let default = targets.pop().unwrap();
                     let (value, _) = self.use_value(state.context, orig_block, new_block, index);
+                    // The select's switch value must be an i32; wrap
+                    // the 64-bit specialization variants' values.
+                    let ty = self.generic.values[index]
+                        .ty(&self.generic.type_pool)
+                        .unwrap();
+                    let value = if ty == Type::I64 {
+                        self.func
+                            .add_op(new_block, Operator::I32WrapI64, &[value], &[Type::I32])
+                    } else {
+                        value
+                    };
                     Terminator::Select {
                         value,
                         targets,
                         default,
                     }
+                } else if let Some((index, candidates)) = state.pending_specialize_cached.take() {
+                    log::trace!(
+                        "Branch to target {} with PendingSpecializeCached on {}",
+                        target.block,
+                        index
+                    );
+                    let index_of_value = target.args.iter().position(|&arg| arg == index).unwrap();
+                    let target_specialized_value =
+                        self.generic.blocks[target.block].params[index_of_value].1;
+                    let (value, _) = self.use_value(state.context, orig_block, new_block, index);
+                    // Build the inline-cache chain: one
+                    // compare-and-branch per candidate, each guarding
+                    // an arm specialized to that candidate value, and
+                    // a final generic fallback. The intermediate
+                    // blocks correspond to no generic block; they
+                    // carry the current flow state so the blockparam
+                    // and stack-sync passes treat them like the
+                    // branching block itself.
+                    let mut first_term = None;
+                    let mut cur = new_block;
+                    let n = candidates.len();
+                    for (i, &candidate) in candidates.iter().enumerate() {
+                        let c = self.state.contexts.create(
+                            Some(new_context),
+                            ContextElem::Specialized(target_specialized_value, candidate),
+                        );
+                        log::trace!(" -> created new context {c} for candidate {candidate}");
+                        let if_true =
+                            self.evaluate_block_target(orig_block, new_block, state, c, target);
+                        let candidate_const = self.func.add_op(
+                            cur,
+                            Operator::I32Const {
+                                value: candidate as u32,
+                            },
+                            &[],
+                            &[Type::I32],
+                        );
+                        let cond = self.func.add_op(
+                            cur,
+                            Operator::I32Eq,
+                            &[value, candidate_const],
+                            &[Type::I32],
+                        );
+                        let (if_false, next) = if i + 1 < n {
+                            let next = self.func.add_block();
+                            self.state.block_entry[next] = state.flow.clone();
+                            self.state.block_exit[next] = state.flow.clone();
+                            self.chain_blocks.push(next);
+                            (
+                                BlockTarget {
+                                    block: next,
+                                    args: vec![],
+                                },
+                                Some(next),
+                            )
+                        } else {
+                            (
+                                self.evaluate_block_target(
+                                    orig_block,
+                                    new_block,
+                                    state,
+                                    new_context,
+                                    target,
+                                ),
+                                None,
+                            )
+                        };
+                        let term = Terminator::CondBr {
+                            cond,
+                            if_true,
+                            if_false,
+                        };
+                        if cur == new_block {
+                            first_term = Some(term);
+                        } else {
+                            self.func.blocks[cur].terminator = term;
+                        }
+                        if let Some(next) = next {
+                            cur = next;
+                        }
+                    }
+                    match first_term {
+                        Some(term) => term,
+                        // An empty candidate list: no cache arms,
+                        // only the generic fallback.
+                        None => Terminator::Br {
+                            target: self.evaluate_block_target(
+                                orig_block,
+                                new_block,
+                                state,
+                                new_context,
+                                target,
+                            ),
+                        },
+                    }
                 } else {
                     // Update pending context with new stack if necessary.
                     Terminator::Br {
@@ -1151,6 +1460,7 @@ impl<'a> Evaluator<'a> {
                 ref default,
             } => {
                 assert!(!state.pending_specialize.is_some());
+                assert!(!state.pending_specialize_cached.is_some());
                 let (value, abs_value) =
                     self.use_value(state.context, orig_block, new_block, value);
                 if let Some(selector) = abs_value.as_const_u32() {
@@ -1255,15 +1565,24 @@ impl<'a> Evaluator<'a> {
             return Ok(reg_result);
         }
 
+        let frame_result = self.abstract_eval_frame(new_block, op, abs, values, state);
+        if frame_result.is_handled() {
+            log::debug!(" -> promoted frame: {frame_result:?}");
+            return Ok(frame_result);
+        }
+
         let ret = if op.is_call() {
             log::debug!(" -> call");
+            for av in abs {
+                self.reject_chunked_buffer_escape(op, av)?;
+            }
             AbstractValue::Runtime(Some(orig_inst))
         } else {
             match abs.len() {
                 0 => self.abstract_eval_nullary(orig_inst, op, state),
                 1 => self.abstract_eval_unary(orig_inst, op, &abs[0], orig_values[0], state)?,
-                2 => self.abstract_eval_binary(orig_inst, op, &abs[0], &abs[1]),
-                3 => self.abstract_eval_ternary(orig_inst, op, &abs[0], &abs[1], &abs[2]),
+                2 => self.abstract_eval_binary(orig_inst, op, &abs[0], &abs[1])?,
+                3 => self.abstract_eval_ternary(orig_inst, op, &abs[0], &abs[1], &abs[2])?,
                 _ => AbstractValue::Runtime(Some(orig_inst)),
             }
         };
@@ -1325,14 +1644,121 @@ impl<'a> Evaluator<'a> {
                     let bucket = abs[0].as_const_u32().unwrap();
                     self.state.contexts.context_bucket[instantaneous_context] = Some(bucket);
                     EvalResult::Elide
+                } else if Some(function_index) == self.intrinsics.context_name {
+                    let instantaneous_context = state.pending_context.unwrap_or(state.context);
+                    let name_ptr = abs[0].as_const_u32().unwrap();
+                    let name = self
+                        .image
+                        .read_str(self.image.main_heap.unwrap(), name_ptr)
+                        .unwrap();
+                    self.state.contexts.context_name[instantaneous_context] = Some(name);
+                    EvalResult::Elide
+                } else if Some(function_index) == self.intrinsics.hint_cold {
+                    let instantaneous_context = state.pending_context.unwrap_or(state.context);
+                    self.state.contexts.context_cold[instantaneous_context] = true;
+                    EvalResult::Elide
+                } else if Some(function_index) == self.intrinsics.expect32 {
+                    let expected = abs[1].as_const_u32().unwrap();
+                    match abs[0].as_const_u32() {
+                        Some(k) if k == expected => self.stats.expect_hits += 1,
+                        Some(k) => {
+                            log::debug!(
+                                "weval_expect32() missed: constant value {k}, expected {expected}"
+                            );
+                            self.stats.expect_misses += 1;
+                        }
+                        None => {}
+                    }
+                    EvalResult::Alias(abs[0].clone(), self.func.arg_pool[values][0])
                 } else if Some(function_index) == self.intrinsics.specialize_value {
-                    let lo = abs[1].as_const_u32().unwrap();
-                    let hi = abs[2].as_const_u32().unwrap();
+                    let lo = u64::from(abs[1].as_const_u32().unwrap());
+                    let hi = u64::from(abs[2].as_const_u32().unwrap());
+                    log::trace!(
+                        "Creating pending-specialize state for index {orig_inst} lo {lo} hi {hi}"
+                    );
+                    state.pending_specialize = Some((orig_inst, lo, hi));
+                    EvalResult::Alias(abs[0].clone(), self.func.arg_pool[values][0])
+                } else if Some(function_index) == self.intrinsics.specialize_value64 {
+                    let lo = abs[1].as_const_u64().unwrap();
+                    let hi = abs[2].as_const_u64().unwrap();
                     log::trace!(
                         "Creating pending-specialize state for index {orig_inst} lo {lo} hi {hi}"
                     );
                     state.pending_specialize = Some((orig_inst, lo, hi));
                     EvalResult::Alias(abs[0].clone(), self.func.arg_pool[values][0])
+                } else if Some(function_index) == self.intrinsics.specialize_value64_masked {
+                    let mask = abs[1].as_const_u64().unwrap();
+                    let shift = mask.trailing_zeros();
+                    let lo = abs[2].as_const_u64().unwrap();
+                    let hi = abs[3].as_const_u64().unwrap();
+                    log::trace!(
+                        "Creating pending-specialize state for index {orig_inst} mask {mask:#x} lo {lo} hi {hi}"
+                    );
+                    // The intrinsic returns the extracted field
+                    // `(value & mask) >> ctz(mask)`; emit that
+                    // computation, and specialize on its result.
+                    let value_arg = self.func.arg_pool[values][0];
+                    let mask_const = self.func.add_op(
+                        new_block,
+                        Operator::I64Const { value: mask },
+                        &[],
+                        &[Type::I64],
+                    );
+                    let masked = self.func.add_op(
+                        new_block,
+                        Operator::I64And,
+                        &[value_arg, mask_const],
+                        &[Type::I64],
+                    );
+                    let field = if shift > 0 {
+                        let shift_const = self.func.add_op(
+                            new_block,
+                            Operator::I64Const {
+                                value: u64::from(shift),
+                            },
+                            &[],
+                            &[Type::I64],
+                        );
+                        self.func.add_op(
+                            new_block,
+                            Operator::I64ShrU,
+                            &[masked, shift_const],
+                            &[Type::I64],
+                        )
+                    } else {
+                        masked
+                    };
+                    let field_abs = match abs[0].as_const_u64() {
+                        Some(value) => {
+                            AbstractValue::Concrete(WasmVal::I64((value & mask) >> shift))
+                        }
+                        None => AbstractValue::Runtime(None),
+                    };
+                    state.pending_specialize = Some((orig_inst, lo, hi));
+                    EvalResult::Alias(field_abs, field)
+                } else if Some(function_index) == self.intrinsics.specialize_cached {
+                    // Inline-cache specialization: the candidate
+                    // values live in a constant array in the
+                    // snapshotted heap. Each candidate gets a guarded
+                    // arm specialized to that value; values outside
+                    // the cache fall back to a generic arm.
+                    let ptr = abs[1].as_const_u32().unwrap();
+                    let n = abs[2].as_const_u32().unwrap();
+                    let heap = self.image.main_heap.unwrap();
+                    let mut candidates: Vec<u64> = vec![];
+                    for i in 0..n {
+                        let candidate = u64::from(self.image.read_u32(heap, ptr + 4 * i).unwrap());
+                        // A duplicate would add a dead arm; keep the
+                        // first occurrence.
+                        if !candidates.contains(&candidate) {
+                            candidates.push(candidate);
+                        }
+                    }
+                    log::trace!(
+                        "Creating pending-specialize-cached state for index {orig_inst} candidates {candidates:?}"
+                    );
+                    state.pending_specialize_cached = Some((orig_inst, candidates));
+                    EvalResult::Alias(abs[0].clone(), self.func.arg_pool[values][0])
                 } else if Some(function_index) == self.intrinsics.abort_specialization {
                     let line_num = abs[0].as_const_u32().unwrap_or(0);
                     let fatal = abs[1].as_const_u32().unwrap_or(0);
@@ -1360,6 +1786,49 @@ impl<'a> Evaluator<'a> {
                         );
                     }
                     EvalResult::Elide
+                } else if Some(function_index) == self.intrinsics.assume_range
+                    || Some(function_index) == self.intrinsics.assume_range64
+                {
+                    let is64 = Some(function_index) == self.intrinsics.assume_range64;
+                    let (lo, hi) = if is64 {
+                        (abs[1].as_const_u64(), abs[2].as_const_u64())
+                    } else {
+                        (
+                            abs[1].as_const_u32().map(u64::from),
+                            abs[2].as_const_u32().map(u64::from),
+                        )
+                    };
+                    log::trace!("assume_range: abs {:?} range {:?}..={:?}", abs[0], lo, hi);
+                    let value = self.func.arg_pool[values][0];
+                    let av = match (lo, hi, &abs[0]) {
+                        // A specialization-time constant: validate the
+                        // assumption now rather than carrying it.
+                        (Some(lo), Some(hi), &AbstractValue::Concrete(k))
+                            if k.integer_value().is_some() =>
+                        {
+                            let k = k.integer_value().unwrap();
+                            if k < lo || k > hi {
+                                panic!(
+                                    "weval_assume_range() violated: constant value {k} not in [{lo}, {hi}]"
+                                );
+                            }
+                            abs[0].clone()
+                        }
+                        (Some(lo), Some(hi), AbstractValue::Runtime(..) | AbstractValue::Top) => {
+                            AbstractValue::Range(lo, hi)
+                        }
+                        // Pointer-like abstract values (and anything
+                        // else) are already more precise than a range;
+                        // keep them as-is.
+                        _ => abs[0].clone(),
+                    };
+                    EvalResult::Alias(av, value)
+                } else if Some(function_index) == self.intrinsics.assume_unreachable {
+                    // Under the verified-bytecode contract this point
+                    // cannot be reached; replace it with a trap so
+                    // that the rest of the (dead) path folds away.
+                    self.func.add_op(new_block, Operator::Unreachable, &[], &[]);
+                    EvalResult::Elide
                 } else if Some(function_index) == self.intrinsics.assert_specialized {
                     log::trace!("assert_specialized: context {:?}", state.context);
                     if state.context.index() == 0 {
@@ -1376,6 +1845,22 @@ impl<'a> Evaluator<'a> {
                     let val = abs[2].clone();
                     log::info!("print: line {line}: {message}: {val:?}");
                     EvalResult::Elide
+                } else if Some(function_index) == self.intrinsics.trace_flush {
+                    // Log any records visible in the image at
+                    // specialization time; a runtime flush point
+                    // (dynamic pointer or count) has nothing for us
+                    // to read and is simply elided.
+                    if let (Some(ptr), Some(n)) = (abs[0].as_const_u32(), abs[1].as_const_u32()) {
+                        let heap = self.image.main_heap.unwrap();
+                        for i in 0..n {
+                            let base = ptr + 16 * i;
+                            let line = self.image.read_u32(heap, base).unwrap();
+                            let kind = self.image.read_u32(heap, base + 4).unwrap();
+                            let value = self.image.read_u64(heap, base + 8).unwrap();
+                            log::debug!("trace record: line {line} kind {kind} value {value}");
+                        }
+                    }
+                    EvalResult::Elide
                 } else if Some(function_index) == self.intrinsics.read_specialization_global {
                     let index = abs[0].as_const_u32().unwrap() as usize;
                     let value = self.func.add_op(
@@ -1387,6 +1872,35 @@ impl<'a> Evaluator<'a> {
                     let state = self.state.specialization_globals[index].clone();
                     log::trace!("read_specialization_global: index {index}: state = {state:?}");
                     EvalResult::Alias(state, value)
+                } else if Some(function_index) == self.intrinsics.read_specialization_globals {
+                    let base = abs[0].as_const_u32().unwrap() as usize;
+                    let count = abs[1].as_const_u32().unwrap();
+                    let out_ptr = self.func.arg_pool[values][2];
+                    log::trace!("bulk read of specialization globals {base}..+{count}");
+                    for i in 0..count {
+                        let value = self.state.specialization_globals[base + i as usize]
+                            .as_const_u64()
+                            .expect("Non-constant specialization global");
+                        let data = self.func.add_op(
+                            new_block,
+                            Operator::I64Const { value },
+                            &[],
+                            &[Type::I64],
+                        );
+                        self.func.add_op(
+                            new_block,
+                            Operator::I64Store {
+                                memory: MemoryArg {
+                                    align: 1,
+                                    offset: 8 * i,
+                                    memory: self.image.main_heap().unwrap(),
+                                },
+                            },
+                            &[out_ptr, data],
+                            &[],
+                        );
+                    }
+                    EvalResult::Elide
                 } else if Some(function_index) == self.intrinsics.push_stack {
                     let stackptr = self.func.arg_pool[values][0];
                     let value = self.func.arg_pool[values][1];
@@ -1554,6 +2068,201 @@ impl<'a> Evaluator<'a> {
                         );
                         self.stats.local_writes_mem += 1;
                     }
+
+                    for (_, (addr, data)) in std::mem::take(&mut state.flow.frame_slots) {
+                        let addr = addr.value().unwrap();
+                        let data = data.value().unwrap();
+                        log::trace!("sync_stack: frame slot addr {addr} data {data}");
+                        self.func.add_op(
+                            new_block,
+                            Operator::I64Store {
+                                memory: MemoryArg {
+                                    align: 1,
+                                    offset: 0,
+                                    memory: self.image.main_heap().unwrap(),
+                                },
+                            },
+                            &[addr, data],
+                            &[],
+                        );
+                        self.stats.local_writes_mem += 1;
+                    }
+                    EvalResult::Elide
+                } else if Some(function_index) == self.intrinsics.pushn_stack {
+                    let stackptr = self.func.arg_pool[values][0];
+                    let n = abs[1].as_const_u32().unwrap();
+                    let in_ptr = self.func.arg_pool[values][2];
+                    log::trace!(
+                        "pushn_stack: n {n}, current stack is {:?}",
+                        state.flow.stack
+                    );
+                    for k in 0..n {
+                        let (addr, addr_abs) = if k == 0 {
+                            (stackptr, abs[0].clone())
+                        } else {
+                            let off = self.func.add_op(
+                                new_block,
+                                Operator::I32Const { value: 8 * k },
+                                &[],
+                                &[Type::I32],
+                            );
+                            let addr = self.func.add_op(
+                                new_block,
+                                Operator::I32Add,
+                                &[stackptr, off],
+                                &[Type::I32],
+                            );
+                            let addr_abs = match abs[0].as_const_u32() {
+                                Some(base) => AbstractValue::Concrete(WasmVal::I32(base + 8 * k)),
+                                None => AbstractValue::Runtime(None),
+                            };
+                            (addr, addr_abs)
+                        };
+                        let load = self.func.add_op(
+                            new_block,
+                            Operator::I64Load {
+                                memory: MemoryArg {
+                                    align: 1,
+                                    offset: 8 * k,
+                                    memory: self.image.main_heap().unwrap(),
+                                },
+                            },
+                            &[in_ptr],
+                            &[Type::I64],
+                        );
+                        state.flow.stack.insert(
+                            0,
+                            (
+                                RegValue::Value {
+                                    data: addr,
+                                    ty: Type::I32,
+                                    abs: addr_abs,
+                                },
+                                RegValue::Value {
+                                    data: load,
+                                    ty: Type::I64,
+                                    abs: AbstractValue::Runtime(None),
+                                },
+                            ),
+                        );
+                        self.stats.virtstack_writes += 1;
+                    }
+                    EvalResult::Elide
+                } else if Some(function_index) == self.intrinsics.popn_stack {
+                    let ptr = self.func.arg_pool[values][0];
+                    let n = abs[1].as_const_u32().unwrap();
+                    let out_ptr = self.func.arg_pool[values][2];
+                    log::trace!("popn_stack: n {n}, current stack is {:?}", state.flow.stack);
+                    // Pop top-first: the top of stack is the
+                    // highest-indexed region entry.
+                    for k in (0..n).rev() {
+                        let value = if state.flow.stack.len() > 0 {
+                            let (_, reg) = state.flow.stack.remove(0);
+                            self.stats.virtstack_reads += 1;
+                            match reg {
+                                RegValue::Value { data, .. } => data,
+                                _ => unreachable!(),
+                            }
+                        } else {
+                            self.stats.virtstack_reads_mem += 1;
+                            self.func.add_op(
+                                new_block,
+                                Operator::I64Load {
+                                    memory: MemoryArg {
+                                        align: 1,
+                                        offset: 8 * k,
+                                        memory: self.image.main_heap().unwrap(),
+                                    },
+                                },
+                                &[ptr],
+                                &[Type::I64],
+                            )
+                        };
+                        self.func.add_op(
+                            new_block,
+                            Operator::I64Store {
+                                memory: MemoryArg {
+                                    align: 1,
+                                    offset: 8 * k,
+                                    memory: self.image.main_heap().unwrap(),
+                                },
+                            },
+                            &[out_ptr, value],
+                            &[],
+                        );
+                    }
+                    EvalResult::Elide
+                } else if Some(function_index) == self.intrinsics.readn_stack {
+                    let ptr = self.func.arg_pool[values][0];
+                    let n = abs[1].as_const_u32().unwrap();
+                    let out_ptr = self.func.arg_pool[values][2];
+                    log::trace!(
+                        "readn_stack: n {n}, current stack is {:?}",
+                        state.flow.stack
+                    );
+                    for k in 0..n {
+                        let idx = (n - 1 - k) as usize;
+                        let value = if let Some((_, data)) = state.flow.stack.get(idx) {
+                            self.stats.virtstack_reads += 1;
+                            match data {
+                                RegValue::Value { data, .. } => *data,
+                                _ => unreachable!(),
+                            }
+                        } else {
+                            self.stats.virtstack_reads_mem += 1;
+                            self.func.add_op(
+                                new_block,
+                                Operator::I64Load {
+                                    memory: MemoryArg {
+                                        align: 1,
+                                        offset: 8 * k,
+                                        memory: self.image.main_heap().unwrap(),
+                                    },
+                                },
+                                &[ptr],
+                                &[Type::I64],
+                            )
+                        };
+                        self.func.add_op(
+                            new_block,
+                            Operator::I64Store {
+                                memory: MemoryArg {
+                                    align: 1,
+                                    offset: 8 * k,
+                                    memory: self.image.main_heap().unwrap(),
+                                },
+                            },
+                            &[out_ptr, value],
+                            &[],
+                        );
+                    }
+                    EvalResult::Elide
+                } else if Some(function_index) == self.intrinsics.sync_stack_partial {
+                    let keep = abs[0].as_const_u32().unwrap() as usize;
+                    log::trace!(
+                        "sync_stack_partial: keep {keep}, current stack is {:?}",
+                        state.flow.stack
+                    );
+                    if state.flow.stack.len() > keep {
+                        for (addr, data) in state.flow.stack.drain(keep..) {
+                            let addr = addr.value().unwrap();
+                            let data = data.value().unwrap();
+                            log::trace!("sync_stack_partial: addr {addr} data {data}");
+                            self.func.add_op(
+                                new_block,
+                                Operator::I64Store {
+                                    memory: MemoryArg {
+                                        align: 1,
+                                        offset: 0,
+                                        memory: self.image.main_heap().unwrap(),
+                                    },
+                                },
+                                &[addr, data],
+                                &[],
+                            );
+                            self.stats.virtstack_writes_mem += 1;
+                        }
+                    }
                     EvalResult::Elide
                 } else if Some(function_index) == self.intrinsics.read_local {
                     self.stats.local_reads += 1;
@@ -1602,6 +2311,11 @@ impl<'a> Evaluator<'a> {
                         ),
                     );
                     EvalResult::Elide
+                } else if Some(function_index) == self.intrinsics.promote_frame {
+                    let count = abs[1].as_const_u32().unwrap();
+                    log::trace!("promote_frame: {count} slots");
+                    self.frame_size = Some(8 * count);
+                    EvalResult::Alias(AbstractValue::FrameAddr(0), self.func.arg_pool[values][0])
                 } else {
                     EvalResult::Unhandled
                 }
@@ -1613,7 +2327,7 @@ impl<'a> Evaluator<'a> {
     fn abstract_eval_regs(
         &mut self,
         _inst: Value,
-        _new_block: Block,
+        new_block: Block,
         op: Operator,
         abs: &[AbstractValue],
         vals: ListRef<Value>,
@@ -1664,12 +2378,229 @@ impl<'a> Evaluator<'a> {
                 // Elide the store.
                 return Ok(EvalResult::Elide);
             }
+            Operator::Call { function_index }
+                if Some(function_index) == self.intrinsics.read_regs =>
+            {
+                let base = abs[0].as_const_u64().expect("Non-constant register number");
+                let count = abs[1].as_const_u32().expect("Non-constant register count");
+                let out_ptr = self.func.arg_pool[vals][2];
+                log::trace!("bulk load from specialization regs {base}..+{count}");
+                for i in 0..count {
+                    let idx = base + u64::from(i);
+                    let slot = RegSlot::Register(idx as u32);
+                    let data = match state.flow.regs.get(&slot) {
+                        Some(RegValue::Value { data, .. }) => *data,
+                        Some(v) => {
+                            anyhow::bail!(
+                                "Specialization register {idx} in bad state {v:?} at read"
+                            );
+                        }
+                        None => {
+                            anyhow::bail!("Specialization register {idx} not set");
+                        }
+                    };
+                    self.func.add_op(
+                        new_block,
+                        Operator::I64Store {
+                            memory: MemoryArg {
+                                align: 1,
+                                offset: 8 * i,
+                                memory: self.image.main_heap().unwrap(),
+                            },
+                        },
+                        &[out_ptr, data],
+                        &[],
+                    );
+                }
+                return Ok(EvalResult::Elide);
+            }
+            Operator::Call { function_index }
+                if Some(function_index) == self.intrinsics.write_regs =>
+            {
+                let base = abs[0].as_const_u64().expect("Non-constant register number");
+                let count = abs[1].as_const_u32().expect("Non-constant register count");
+                let in_ptr = self.func.arg_pool[vals][2];
+                log::trace!("bulk store to specialization regs {base}..+{count}");
+                for i in 0..count {
+                    let idx = base + u64::from(i);
+                    let load = self.func.add_op(
+                        new_block,
+                        Operator::I64Load {
+                            memory: MemoryArg {
+                                align: 1,
+                                offset: 8 * i,
+                                memory: self.image.main_heap().unwrap(),
+                            },
+                        },
+                        &[in_ptr],
+                        &[Type::I64],
+                    );
+                    state.flow.regs.insert(
+                        RegSlot::Register(idx as u32),
+                        RegValue::Value {
+                            data: load,
+                            ty: Type::I64,
+                            abs: AbstractValue::Runtime(None),
+                        },
+                    );
+                }
+                return Ok(EvalResult::Elide);
+            }
             _ => {}
         }
 
         Ok(EvalResult::Unhandled)
     }
 
+    /// Abstract evaluation of plain loads and stores into a frame
+    /// declared private via `weval_promote_frame()`. Aligned 8-byte
+    /// accesses at constant offsets into the frame are virtualized
+    /// into `ProgPointState::frame_slots` -- stores are elided until a
+    /// sync point and loads alias the pending value -- so frame
+    /// traffic is SSA-promoted without per-access intrinsics.
+    /// Narrower or misaligned accesses spill any overlapping virtual
+    /// slot first and then go to memory as usual.
+    fn abstract_eval_frame(
+        &mut self,
+        new_block: Block,
+        op: Operator,
+        abs: &[AbstractValue],
+        vals: ListRef<Value>,
+        state: &mut PointState,
+    ) -> EvalResult {
+        let base = match abs.first() {
+            Some(&AbstractValue::FrameAddr(offset)) => offset,
+            _ => return EvalResult::Unhandled,
+        };
+        let frame_size = match self.frame_size {
+            Some(size) => size,
+            None => return EvalResult::Unhandled,
+        };
+        let (memory, size) = match op {
+            Operator::I32Load8S { memory }
+            | Operator::I32Load8U { memory }
+            | Operator::I64Load8S { memory }
+            | Operator::I64Load8U { memory }
+            | Operator::I32Store8 { memory }
+            | Operator::I64Store8 { memory } => (memory, 1),
+            Operator::I32Load16S { memory }
+            | Operator::I32Load16U { memory }
+            | Operator::I64Load16S { memory }
+            | Operator::I64Load16U { memory }
+            | Operator::I32Store16 { memory }
+            | Operator::I64Store16 { memory } => (memory, 2),
+            Operator::I32Load { memory }
+            | Operator::I64Load32S { memory }
+            | Operator::I64Load32U { memory }
+            | Operator::F32Load { memory }
+            | Operator::I32Store { memory }
+            | Operator::I64Store32 { memory }
+            | Operator::F32Store { memory } => (memory, 4),
+            Operator::I64Load { memory }
+            | Operator::F64Load { memory }
+            | Operator::I64Store { memory }
+            | Operator::F64Store { memory } => (memory, 8),
+            _ => return EvalResult::Unhandled,
+        };
+        let offset = base.wrapping_add(memory.offset);
+
+        if offset % 8 == 0 && offset.saturating_add(8) <= frame_size {
+            let slot = offset / 8;
+            match op {
+                Operator::I64Load { .. } => {
+                    self.stats.local_reads += 1;
+                    match state.flow.frame_slots.get(&slot) {
+                        Some((_, RegValue::Value { data, abs, .. })) => {
+                            return EvalResult::Alias(abs.clone(), *data);
+                        }
+                        Some(_) => unreachable!(),
+                        None => {
+                            // Nothing pending for this slot; memory
+                            // is up to date.
+                            self.stats.local_reads_mem += 1;
+                            return EvalResult::Unhandled;
+                        }
+                    }
+                }
+                Operator::I64Store { .. } => {
+                    self.stats.local_writes += 1;
+                    // Record the slot address for the eventual spill
+                    // at a sync point; fold the static memory-arg
+                    // offset into it, since the spill stores at
+                    // offset 0.
+                    let addr = if memory.offset == 0 {
+                        self.func.arg_pool[vals][0]
+                    } else {
+                        let k = self.func.add_op(
+                            new_block,
+                            Operator::I32Const {
+                                value: memory.offset,
+                            },
+                            &[],
+                            &[Type::I32],
+                        );
+                        self.func.add_op(
+                            new_block,
+                            Operator::I32Add,
+                            &[self.func.arg_pool[vals][0], k],
+                            &[Type::I32],
+                        )
+                    };
+                    let data = self.func.arg_pool[vals][1];
+                    state.flow.frame_slots.insert(
+                        slot,
+                        (
+                            RegValue::Value {
+                                data: addr,
+                                abs: AbstractValue::FrameAddr(offset),
+                                ty: Type::I32,
+                            },
+                            RegValue::Value {
+                                data,
+                                abs: abs[1].clone(),
+                                ty: Type::I64,
+                            },
+                        ),
+                    );
+                    return EvalResult::Elide;
+                }
+                _ => {}
+            }
+        }
+
+        // A narrower, misaligned, or non-integer access: spill any
+        // overlapping pending slot so memory is current, then let the
+        // access proceed as usual.
+        let first = offset / 8;
+        let last = offset.saturating_add(size - 1) / 8;
+        for slot in first..=last {
+            self.flush_frame_slot(new_block, state, slot);
+        }
+        EvalResult::Unhandled
+    }
+
+    /// Spills one pending virtualized frame slot back to memory, if
+    /// present.
+    fn flush_frame_slot(&mut self, new_block: Block, state: &mut PointState, slot: u32) {
+        if let Some((addr, data)) = state.flow.frame_slots.remove(&slot) {
+            let addr = addr.value().unwrap();
+            let data = data.value().unwrap();
+            self.func.add_op(
+                new_block,
+                Operator::I64Store {
+                    memory: MemoryArg {
+                        align: 1,
+                        offset: 0,
+                        memory: self.image.main_heap().unwrap(),
+                    },
+                },
+                &[addr, data],
+                &[],
+            );
+            self.stats.local_writes_mem += 1;
+        }
+    }
+
     fn abstract_eval_nullary(
         &mut self,
         orig_inst: Value,
@@ -1691,6 +2622,34 @@ impl<'a> Evaluator<'a> {
         }
     }
 
+    /// Fails the directive if `val` is a symbolic pointer into a
+    /// chunked constant buffer (`SpecializeMemoryChunked`) that is
+    /// about to degrade to a runtime value. The wasm-level argument
+    /// holds a pointer to the segment table, not to the concatenated
+    /// contents, so a residual access through it in the specialized
+    /// body would read the segment table rather than the buffered
+    /// data; failing here makes the guest fall back to the generic
+    /// function instead of running silently-wrong code.
+    fn reject_chunked_buffer_escape(
+        &self,
+        op: Operator,
+        val: &AbstractValue,
+    ) -> anyhow::Result<()> {
+        if let AbstractValue::ConcreteMemory(buf, _) = val {
+            let chunked = self.directive_args.const_memory[buf.0 as usize]
+                .as_ref()
+                .map_or(false, |mem| mem.is_chunked());
+            if chunked {
+                anyhow::bail!(
+                    "Pointer to chunked constant buffer escapes to a runtime value at `{op:?}`; \
+                     every access through a `SpecializeMemoryChunked` argument must fold at \
+                     specialization time"
+                );
+            }
+        }
+        Ok(())
+    }
+
     fn abstract_eval_unary(
         &mut self,
         orig_inst: Value,
@@ -1857,7 +2816,10 @@ impl<'a> Evaluator<'a> {
             }
 
             // TODO: FP and SIMD
-            _ => Ok(AbstractValue::Runtime(Some(orig_inst))),
+            _ => {
+                self.reject_chunked_buffer_escape(op, x)?;
+                Ok(AbstractValue::Runtime(Some(orig_inst)))
+            }
         }
     }
 
@@ -1867,8 +2829,8 @@ impl<'a> Evaluator<'a> {
         op: Operator,
         x: &AbstractValue,
         y: &AbstractValue,
-    ) -> AbstractValue {
-        match (x, y) {
+    ) -> anyhow::Result<AbstractValue> {
+        Ok(match (x, y) {
             (AbstractValue::Concrete(v1), AbstractValue::Concrete(v2)) => {
                 match (op, v1, v2) {
                     // 32-bit comparisons.
@@ -2122,6 +3084,18 @@ impl<'a> Evaluator<'a> {
                 AbstractValue::ConcreteMemory(buf.clone(), offset.wrapping_sub(*k))
             }
 
+            (AbstractValue::FrameAddr(offset), AbstractValue::Concrete(WasmVal::I32(k)))
+            | (AbstractValue::Concrete(WasmVal::I32(k)), AbstractValue::FrameAddr(offset))
+                if op == Operator::I32Add =>
+            {
+                AbstractValue::FrameAddr(offset.wrapping_add(*k))
+            }
+            (AbstractValue::FrameAddr(offset), AbstractValue::Concrete(WasmVal::I32(k)))
+                if op == Operator::I32Sub =>
+            {
+                AbstractValue::FrameAddr(offset.wrapping_sub(*k))
+            }
+
             // ptr OP ptr
             (
                 AbstractValue::ConcreteMemory(buf1, offset1),
@@ -2130,8 +3104,63 @@ impl<'a> Evaluator<'a> {
                 AbstractValue::Concrete(WasmVal::I32(offset1.wrapping_sub(*offset2)))
             }
 
-            _ => AbstractValue::Runtime(Some(orig_inst)),
-        }
+            // range OP const | const OP range: shift the assumed
+            // range by a constant, when this cannot wrap.
+            (AbstractValue::Range(lo, hi), AbstractValue::Concrete(k))
+            | (AbstractValue::Concrete(k), AbstractValue::Range(lo, hi))
+                if (op == Operator::I32Add || op == Operator::I64Add)
+                    && k.integer_value().is_some() =>
+            {
+                let k = k.integer_value().unwrap();
+                let max = if op == Operator::I32Add {
+                    u64::from(u32::MAX)
+                } else {
+                    u64::MAX
+                };
+                match (lo.checked_add(k), hi.checked_add(k)) {
+                    (Some(lo), Some(hi)) if hi <= max => AbstractValue::Range(lo, hi),
+                    _ => AbstractValue::Runtime(Some(orig_inst)),
+                }
+            }
+            (AbstractValue::Range(lo, hi), AbstractValue::Concrete(k))
+                if (op == Operator::I32Sub || op == Operator::I64Sub)
+                    && k.integer_value().is_some() =>
+            {
+                let k = k.integer_value().unwrap();
+                match (lo.checked_sub(k), hi.checked_sub(k)) {
+                    (Some(lo), Some(hi)) => AbstractValue::Range(lo, hi),
+                    _ => AbstractValue::Runtime(Some(orig_inst)),
+                }
+            }
+
+            // Unsigned comparisons against assumed ranges: fold when
+            // the ranges are conclusive either way. This is the
+            // payoff of `weval_assume_range()`: a bounds check
+            // against a constant limit becomes constant-false (or
+            // -true) and the guarded path folds away.
+            (AbstractValue::Range(xlo, xhi), AbstractValue::Range(ylo, yhi)) => {
+                range_cmp(&op, *xlo, *xhi, *ylo, *yhi)
+                    .unwrap_or(AbstractValue::Runtime(Some(orig_inst)))
+            }
+            (AbstractValue::Range(xlo, xhi), AbstractValue::Concrete(k))
+                if k.integer_value().is_some() =>
+            {
+                let k = k.integer_value().unwrap();
+                range_cmp(&op, *xlo, *xhi, k, k).unwrap_or(AbstractValue::Runtime(Some(orig_inst)))
+            }
+            (AbstractValue::Concrete(k), AbstractValue::Range(ylo, yhi))
+                if k.integer_value().is_some() =>
+            {
+                let k = k.integer_value().unwrap();
+                range_cmp(&op, k, k, *ylo, *yhi).unwrap_or(AbstractValue::Runtime(Some(orig_inst)))
+            }
+
+            _ => {
+                self.reject_chunked_buffer_escape(op, x)?;
+                self.reject_chunked_buffer_escape(op, y)?;
+                AbstractValue::Runtime(Some(orig_inst))
+            }
+        })
     }
 
     fn abstract_eval_ternary(
@@ -2141,8 +3170,8 @@ impl<'a> Evaluator<'a> {
         x: &AbstractValue,
         y: &AbstractValue,
         z: &AbstractValue,
-    ) -> AbstractValue {
-        match (op, z) {
+    ) -> anyhow::Result<AbstractValue> {
+        Ok(match (op, z) {
             (Operator::Select, AbstractValue::Concrete(v))
             | (Operator::TypedSelect { .. }, AbstractValue::Concrete(v)) => {
                 if v.is_truthy() {
@@ -2154,8 +3183,13 @@ impl<'a> Evaluator<'a> {
             // Concrete-memory symbolic pointers are always truthy.
             (Operator::Select, AbstractValue::ConcreteMemory(..))
             | (Operator::TypedSelect { .. }, AbstractValue::ConcreteMemory(..)) => x.clone(),
-            _ => AbstractValue::Runtime(Some(orig_inst)),
-        }
+            _ => {
+                self.reject_chunked_buffer_escape(op, x)?;
+                self.reject_chunked_buffer_escape(op, y)?;
+                self.reject_chunked_buffer_escape(op, z)?;
+                AbstractValue::Runtime(Some(orig_inst))
+            }
+        })
     }
 
     fn add_blockparam_reg_args(&mut self) -> anyhow::Result<()> {
@@ -2190,6 +3224,10 @@ impl<'a> Evaluator<'a> {
                 handle_value(RegSlot::LocalAddr(i), addr)?;
                 handle_value(RegSlot::LocalData(i), data)?;
             }
+            for (&i, (addr, data)) in succ_state.frame_slots.iter() {
+                handle_value(RegSlot::FrameAddr(i), addr)?;
+                handle_value(RegSlot::FrameData(i), data)?;
+            }
 
             for pred_idx in 0..self.func.blocks[block].preds.len() {
                 let pred = self.func.blocks[block].preds[pred_idx];
@@ -2203,6 +3241,8 @@ impl<'a> Evaluator<'a> {
                         RegSlot::StackData(i) => &pred_state.stack.get(i as usize).unwrap().1,
                         RegSlot::LocalAddr(i) => &pred_state.locals.get(&i).unwrap().0,
                         RegSlot::LocalData(i) => &pred_state.locals.get(&i).unwrap().1,
+                        RegSlot::FrameAddr(i) => &pred_state.frame_slots.get(&i).unwrap().0,
+                        RegSlot::FrameData(i) => &pred_state.frame_slots.get(&i).unwrap().1,
                     };
                     let pred_val = pred_reg.value().unwrap();
                     self.func.blocks[pred]
@@ -2224,7 +3264,13 @@ impl<'a> Evaluator<'a> {
         //
         // Also look at `locals` and find locals present in pred and
         // not in some succ, and sync them.
-        for (_, &block) in &self.block_map {
+        let blocks = self
+            .block_map
+            .values()
+            .copied()
+            .chain(self.chain_blocks.iter().copied())
+            .collect::<Vec<_>>();
+        for block in blocks {
             if self.func.blocks[block].succs.is_empty() {
                 continue;
             }
@@ -2287,6 +3333,38 @@ impl<'a> Evaluator<'a> {
                     &[],
                 );
             }
+
+            let frame_slots_to_sync = pred_state
+                .frame_slots
+                .keys()
+                .filter(|key| {
+                    self.func.blocks[block]
+                        .succs
+                        .iter()
+                        .any(|succ| !self.state.block_entry[*succ].frame_slots.contains_key(key))
+                })
+                .cloned()
+                .collect::<Vec<_>>();
+            for slot in frame_slots_to_sync {
+                let (addr, data) = pred_state.frame_slots.get(&slot).unwrap();
+                let addr = addr.value().unwrap();
+                let data = data.value().unwrap();
+                log::trace!(
+                    "spilling frame slot {slot} back to frame memory: addr {addr} data {data}"
+                );
+                self.func.add_op(
+                    block,
+                    Operator::I64Store {
+                        memory: MemoryArg {
+                            align: 1,
+                            offset: 0,
+                            memory: self.image.main_heap().unwrap(),
+                        },
+                    },
+                    &[addr, data],
+                    &[],
+                );
+            }
         }
     }
 
@@ -56,17 +56,40 @@ fn gen_replacement_bytecode(
         "write.global.1" => Ok(vec![wasm_encoder::Instruction::GlobalSet(
             weval_globals + 1,
         )]),
+        // Polyfilled to the generic semantics `(value & mask) >>
+        // ctz(mask)`. The mask is needed twice and wasm has no way to
+        // dup a stack operand, so it is parked in a scratch global.
+        "specialize.value64.masked" => Ok(vec![
+            wasm_encoder::Instruction::Drop, // hi
+            wasm_encoder::Instruction::Drop, // lo
+            wasm_encoder::Instruction::GlobalSet(weval_globals + 2),
+            wasm_encoder::Instruction::GlobalGet(weval_globals + 2),
+            wasm_encoder::Instruction::I64And,
+            wasm_encoder::Instruction::GlobalGet(weval_globals + 2),
+            wasm_encoder::Instruction::I64Ctz,
+            wasm_encoder::Instruction::I64ShrU,
+        ]),
+        // The assumption point is by contract unreachable in the
+        // generic code too, so the trap is the faithful polyfill.
+        "assume.unreachable" => Ok(vec![wasm_encoder::Instruction::Unreachable]),
         // These can't be polyfilled so we rewrite them to
         // trap. They're only used in template-specialized variants
         // fed to weval requests.
         "read.specialization.global"
+        | "read.specialization.globals"
         | "read.reg"
         | "write.reg"
+        | "read.regs"
+        | "write.regs"
         | "push.stack"
         | "pop.stack"
         | "read.stack"
         | "write.stack"
         | "sync.stack"
+        | "pushn.stack"
+        | "popn.stack"
+        | "readn.stack"
+        | "sync.stack.partial"
         | "read.local"
         | "write.local" => Ok(vec![wasm_encoder::Instruction::Unreachable]),
 
@@ -197,7 +220,9 @@ impl Rewrite {
                     false
                 }
 
-                // Globals section: add two mut i64 globals for {read,write}.global.{0,1}.
+                // Globals section: add two mut i64 globals for
+                // {read,write}.global.{0,1}, plus a scratch global for
+                // the specialize.value64.masked polyfill.
                 Payload::GlobalSection(globals) => {
                     let mut out_globals = wasm_encoder::GlobalSection::new();
                     for global in globals.into_iter() {
@@ -243,7 +268,7 @@ impl Rewrite {
                         out_globals.global(ty, &init_expr);
                     }
 
-                    for _ in 0..2 {
+                    for _ in 0..3 {
                         out_globals.global(
                             wasm_encoder::GlobalType {
                                 val_type: wasm_encoder::ValType::I64,
@@ -425,6 +425,17 @@ impl Image {
         Ok(())
     }
 
+    pub(crate) fn write_u64(&mut self, id: Memory, addr: u32, value: u64) -> anyhow::Result<()> {
+        let image = self.memories.get_mut(&id).unwrap();
+        let addr = addr as usize;
+        if (addr + 8) > image.len() {
+            anyhow::bail!("Out of bounds");
+        }
+        let slice = &mut image.image[addr..(addr + 8)];
+        slice.copy_from_slice(&value.to_le_bytes()[..]);
+        Ok(())
+    }
+
     pub(crate) fn func_ptr(&self, idx: u32) -> anyhow::Result<Func> {
         let table = self
             .main_table
@@ -6,24 +6,42 @@ use waffle::{ExportKind, Func, ImportKind, Module, Operator, Terminator, Type, V
 pub(crate) struct Intrinsics {
     pub read_reg: Option<Func>,
     pub write_reg: Option<Func>,
+    pub read_regs: Option<Func>,
+    pub write_regs: Option<Func>,
     pub push_context: Option<Func>,
     pub pop_context: Option<Func>,
     pub update_context: Option<Func>,
     pub context_bucket: Option<Func>,
+    pub context_name: Option<Func>,
     pub abort_specialization: Option<Func>,
     pub trace_line: Option<Func>,
+    pub trace_flush: Option<Func>,
     pub assert_const32: Option<Func>,
+    pub assume_range: Option<Func>,
+    pub assume_range64: Option<Func>,
+    pub assume_unreachable: Option<Func>,
+    pub hint_cold: Option<Func>,
+    pub expect32: Option<Func>,
     pub assert_specialized: Option<Func>,
     pub specialize_value: Option<Func>,
+    pub specialize_value64: Option<Func>,
+    pub specialize_value64_masked: Option<Func>,
+    pub specialize_cached: Option<Func>,
     pub print: Option<Func>,
     pub read_specialization_global: Option<Func>,
+    pub read_specialization_globals: Option<Func>,
     pub push_stack: Option<Func>,
     pub sync_stack: Option<Func>,
     pub read_stack: Option<Func>,
     pub write_stack: Option<Func>,
     pub pop_stack: Option<Func>,
+    pub pushn_stack: Option<Func>,
+    pub popn_stack: Option<Func>,
+    pub readn_stack: Option<Func>,
+    pub sync_stack_partial: Option<Func>,
     pub read_local: Option<Func>,
     pub write_local: Option<Func>,
+    pub promote_frame: Option<Func>,
 }
 
 impl Intrinsics {
@@ -31,10 +49,23 @@ impl Intrinsics {
         Intrinsics {
             read_reg: find_imported_intrinsic(module, "read.reg", &[Type::I64], &[Type::I64]),
             write_reg: find_imported_intrinsic(module, "write.reg", &[Type::I64, Type::I64], &[]),
+            read_regs: find_imported_intrinsic(
+                module,
+                "read.regs",
+                &[Type::I64, Type::I32, Type::I32],
+                &[],
+            ),
+            write_regs: find_imported_intrinsic(
+                module,
+                "write.regs",
+                &[Type::I64, Type::I32, Type::I32],
+                &[],
+            ),
             push_context: find_imported_intrinsic(module, "push.context", &[Type::I32], &[]),
             pop_context: find_imported_intrinsic(module, "pop.context", &[], &[]),
             update_context: find_imported_intrinsic(module, "update.context", &[Type::I32], &[]),
             context_bucket: find_imported_intrinsic(module, "context.bucket", &[Type::I32], &[]),
+            context_name: find_imported_intrinsic(module, "context.name", &[Type::I32], &[]),
             abort_specialization: find_imported_intrinsic(
                 module,
                 "abort.specialization",
@@ -42,12 +73,38 @@ impl Intrinsics {
                 &[],
             ),
             trace_line: find_imported_intrinsic(module, "trace.line", &[Type::I32], &[]),
+            trace_flush: find_imported_intrinsic(
+                module,
+                "trace.flush",
+                &[Type::I32, Type::I32],
+                &[],
+            ),
             assert_const32: find_imported_intrinsic(
                 module,
                 "assert.const32",
                 &[Type::I32, Type::I32],
                 &[],
             ),
+            assume_range: find_imported_intrinsic(
+                module,
+                "assume.range",
+                &[Type::I32, Type::I32, Type::I32],
+                &[Type::I32],
+            ),
+            assume_range64: find_imported_intrinsic(
+                module,
+                "assume.range64",
+                &[Type::I64, Type::I64, Type::I64],
+                &[Type::I64],
+            ),
+            assume_unreachable: find_imported_intrinsic(module, "assume.unreachable", &[], &[]),
+            hint_cold: find_imported_intrinsic(module, "hint.cold", &[], &[]),
+            expect32: find_imported_intrinsic(
+                module,
+                "expect32",
+                &[Type::I32, Type::I32],
+                &[Type::I32],
+            ),
             assert_specialized: find_imported_intrinsic(
                 module,
                 "assert.specialized",
@@ -60,6 +117,24 @@ impl Intrinsics {
                 &[Type::I32, Type::I32, Type::I32],
                 &[Type::I32],
             ),
+            specialize_value64: find_imported_intrinsic(
+                module,
+                "specialize.value64",
+                &[Type::I64, Type::I64, Type::I64],
+                &[Type::I64],
+            ),
+            specialize_value64_masked: find_imported_intrinsic(
+                module,
+                "specialize.value64.masked",
+                &[Type::I64, Type::I64, Type::I64, Type::I64],
+                &[Type::I64],
+            ),
+            specialize_cached: find_imported_intrinsic(
+                module,
+                "specialize.cached",
+                &[Type::I32, Type::I32, Type::I32],
+                &[Type::I32],
+            ),
             print: find_imported_intrinsic(
                 module,
                 "print",
@@ -72,6 +147,12 @@ impl Intrinsics {
                 &[Type::I32],
                 &[Type::I64],
             ),
+            read_specialization_globals: find_imported_intrinsic(
+                module,
+                "read.specialization.globals",
+                &[Type::I32, Type::I32, Type::I32],
+                &[],
+            ),
 
             push_stack: find_imported_intrinsic(module, "push.stack", &[Type::I32, Type::I64], &[]),
             sync_stack: find_imported_intrinsic(module, "sync.stack", &[], &[]),
@@ -88,6 +169,30 @@ impl Intrinsics {
                 &[],
             ),
             pop_stack: find_imported_intrinsic(module, "pop.stack", &[Type::I32], &[Type::I64]),
+            pushn_stack: find_imported_intrinsic(
+                module,
+                "pushn.stack",
+                &[Type::I32, Type::I32, Type::I32],
+                &[],
+            ),
+            popn_stack: find_imported_intrinsic(
+                module,
+                "popn.stack",
+                &[Type::I32, Type::I32, Type::I32],
+                &[],
+            ),
+            readn_stack: find_imported_intrinsic(
+                module,
+                "readn.stack",
+                &[Type::I32, Type::I32, Type::I32],
+                &[],
+            ),
+            sync_stack_partial: find_imported_intrinsic(
+                module,
+                "sync.stack.partial",
+                &[Type::I32],
+                &[],
+            ),
             read_local: find_imported_intrinsic(
                 module,
                 "read.local",
@@ -100,6 +205,12 @@ impl Intrinsics {
                 &[Type::I32, Type::I32, Type::I64],
                 &[],
             ),
+            promote_frame: find_imported_intrinsic(
+                module,
+                "promote.frame",
+                &[Type::I32, Type::I32],
+                &[Type::I32],
+            ),
         }
     }
 }
@@ -78,6 +78,18 @@ pub enum Command {
         #[structopt(long = "output-ir")]
         output_ir: Option<PathBuf>,
 
+        /// Write a machine-readable (JSON lines) per-context profile
+        /// of specialized code size and specialization time to the
+        /// given file.
+        #[structopt(long = "profile-out")]
+        profile_out: Option<PathBuf>,
+
+        /// Specialize at most this many directives, in descending
+        /// request-priority order; the rest fall back to the generic
+        /// functions.
+        #[structopt(long = "max-specializations")]
+        max_specializations: Option<usize>,
+
         /// Emit verbose progress messages.
         #[structopt(short = "v", long = "verbose")]
         verbose: bool,
@@ -103,6 +115,8 @@ fn main() -> anyhow::Result<()> {
             cache_ro,
             show_stats,
             output_ir,
+            profile_out,
+            max_specializations,
             verbose,
         } => weval(
             input_module,
@@ -115,6 +129,8 @@ fn main() -> anyhow::Result<()> {
             cache_ro,
             show_stats,
             output_ir,
+            profile_out,
+            max_specializations,
             verbose,
             WasiOpts {
                 p2: allow_wasip2,
@@ -187,6 +203,8 @@ fn weval(
     cache_ro: Option<PathBuf>,
     show_stats: bool,
     output_ir: Option<PathBuf>,
+    profile_out: Option<PathBuf>,
+    max_specializations: Option<usize>,
     verbose: bool,
     wasi: WasiOpts,
 ) -> anyhow::Result<()> {
@@ -231,6 +249,8 @@ fn weval(
                 module_hash: input_hash,
                 show_stats,
                 output_ir,
+                profile_out,
+                max_specializations,
                 verbose,
             },
         )?,
@@ -241,6 +261,8 @@ fn weval(
                 cache_ro,
                 show_stats,
                 output_ir,
+                profile_out,
+                max_specializations,
                 verbose,
             },
         )?,
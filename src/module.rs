@@ -3,7 +3,7 @@ use std::path::PathBuf;
 use wasmtime::{Config, Engine, Linker, Module, Store};
 use wasmtime_wasi::p1;
 
-use crate::{cache, configure_wasi, directive, eval, filter, image};
+use crate::{cache, configure_wasi, directive, eval, filter, image, stats};
 
 const STUBS: &str = include_str!("../lib/weval-stubs.wat");
 
@@ -13,6 +13,8 @@ pub(crate) struct Opts {
     pub(crate) module_hash: cache::ModuleHash,
     pub(crate) show_stats: bool,
     pub(crate) output_ir: Option<PathBuf>,
+    pub(crate) profile_out: Option<PathBuf>,
+    pub(crate) max_specializations: Option<usize>,
     pub(crate) verbose: bool,
 }
 
@@ -102,6 +104,7 @@ pub(crate) fn weval(module_bytes: &[u8], opts: Opts) -> anyhow::Result<Vec<u8>>
         progress,
         opts.output_ir,
         &cache,
+        opts.max_specializations,
     )?;
 
     // Update memories in module.
@@ -112,6 +115,13 @@ pub(crate) fn weval(module_bytes: &[u8], opts: Opts) -> anyhow::Result<Vec<u8>>
 
     log::debug!("Final module:\n{}", result.module.display());
 
+    if let Some(path) = &opts.profile_out {
+        if opts.verbose {
+            eprintln!("Writing per-context profile...");
+        }
+        stats::write_profiles(path, &result.profiles)?;
+    }
+
     if opts.show_stats {
         for stats in result.stats {
             eprintln!(
@@ -136,6 +146,12 @@ pub(crate) fn weval(module_bytes: &[u8], opts: Opts) -> anyhow::Result<Vec<u8>>
                 stats.local_writes,
                 stats.local_writes_mem
             );
+            if stats.expect_hits + stats.expect_misses > 0 {
+                eprintln!(
+                    "   expect hints: {} confirmed, {} missed",
+                    stats.expect_hits, stats.expect_misses
+                );
+            }
             eprintln!(
                 "   live values at block starts: {} ({} per block)",
                 stats.live_value_at_block_start,
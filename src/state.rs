@@ -51,7 +51,7 @@ pub(crate) type PC = u32;
 pub(crate) enum ContextElem {
     Root,
     Loop(PC),
-    Specialized(Value, u32),
+    Specialized(Value, u64),
 }
 
 /// Arena of contexts.
@@ -59,6 +59,13 @@ pub(crate) enum ContextElem {
 pub(crate) struct Contexts {
     contexts: EntityVec<Context, (Context, ContextElem)>,
     pub(crate) context_bucket: PerEntity<Context, Option<u32>>,
+    /// Guest-provided names, from `weval_context_name()`; used for
+    /// profile attribution.
+    pub(crate) context_name: PerEntity<Context, Option<String>>,
+    /// Contexts marked rarely-executed via `weval_hint_cold()`;
+    /// surfaced in the profile so cold code interleaved with hot
+    /// specialized code can be found.
+    pub(crate) context_cold: PerEntity<Context, bool>,
     dedup: HashMap<(Context, ContextElem), Context>, // map from (parent, tail_elem) to ID
 }
 
@@ -110,8 +117,15 @@ pub(crate) struct ProgPointState {
     /// Each entry is an (address, data) pair.
     pub stack: Vec<(RegValue, RegValue)>,
     /// Virtualized locals, with (address, data) pairs for spilling
-    /// back to memory at sync points.
+    /// back to memory at sync points. Keyed by the guest-chosen local
+    /// index passed to `weval_read_local()`/`weval_write_local()`.
     pub locals: BTreeMap<u32, (RegValue, RegValue)>,
+    /// Virtualized slots of a frame declared private via
+    /// `weval_promote_frame()`, keyed by 8-byte slot index (byte
+    /// offset / 8). Kept separate from `locals`: that map is keyed by
+    /// guest-chosen indices, which would alias frame offsets in a
+    /// function using both features.
+    pub frame_slots: BTreeMap<u32, (RegValue, RegValue)>,
 }
 
 #[derive(Clone, Copy, Debug, PartialEq, Eq, PartialOrd, Ord, Hash)]
@@ -121,6 +135,8 @@ pub(crate) enum RegSlot {
     LocalData(u32),
     StackData(u32),
     StackAddr(u32),
+    FrameAddr(u32),
+    FrameData(u32),
 }
 
 #[derive(Clone, Debug, PartialEq, Eq, PartialOrd, Ord, Hash)]
@@ -215,7 +231,12 @@ pub(crate) struct FunctionState {
 pub(crate) struct PointState {
     pub context: Context,
     pub pending_context: Option<Context>,
-    pub pending_specialize: Option<(Value, u32, u32)>,
+    pub pending_specialize: Option<(Value, u64, u64)>,
+    /// Like `pending_specialize`, but over an explicit candidate list
+    /// (`weval.specialize.cached`): the branch is compiled to a
+    /// compare-and-branch chain over the candidates, with a generic
+    /// fallback, rather than a dense switch.
+    pub pending_specialize_cached: Option<(Value, Vec<u64>)>,
     pub flow: ProgPointState,
 }
 
@@ -297,6 +318,7 @@ impl ProgPointState {
             globals,
             stack: vec![],
             locals: BTreeMap::new(),
+            frame_slots: BTreeMap::new(),
         }
     }
 
@@ -331,6 +353,13 @@ impl ProgPointState {
             None,
         );
 
+        changed |= map_meet_with(
+            &mut self.frame_slots,
+            &other.frame_slots,
+            |(a0, a1), (b0, b1)| (RegValue::meet(a0, b0), RegValue::meet(a1, b1)),
+            None,
+        );
+
         changed
     }
 
@@ -357,6 +386,10 @@ impl ProgPointState {
             create_merge(addr);
             create_merge(data);
         }
+        for (addr, data) in self.frame_slots.values_mut() {
+            create_merge(addr);
+            create_merge(data);
+        }
     }
 
     pub(crate) fn update_at_block_entry<C, GB: FnMut(&mut C, RegSlot, Type) -> Value>(
@@ -386,6 +419,10 @@ impl ProgPointState {
             handle_value(RegSlot::LocalAddr(*i), addr);
             handle_value(RegSlot::LocalData(*i), value);
         }
+        for (i, (addr, value)) in self.frame_slots.iter_mut() {
+            handle_value(RegSlot::FrameAddr(*i), addr);
+            handle_value(RegSlot::FrameData(*i), value);
+        }
 
         Ok(())
     }
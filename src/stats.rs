@@ -1,6 +1,8 @@
 //! Post-specialization stats.
 
 use fxhash::FxHashSet;
+use std::io::Write;
+use std::path::Path;
 use waffle::{Block, Func, FunctionBody};
 
 /// Stats per original/generic function.
@@ -24,6 +26,11 @@ pub(crate) struct SpecializationStats {
     pub local_reads_mem: usize,
     pub local_writes_mem: usize,
     pub live_value_at_block_start: usize,
+    /// `weval_expect32()` sites whose value folded to the expected
+    /// constant, and sites that folded to something else (a misplaced
+    /// hint).
+    pub expect_hits: usize,
+    pub expect_misses: usize,
 }
 
 impl SpecializationStats {
@@ -49,9 +56,99 @@ impl SpecializationStats {
         self.local_writes += stats.local_writes;
         self.local_writes_mem += stats.local_writes_mem;
         self.live_value_at_block_start += stats.live_value_at_block_start;
+        self.expect_hits += stats.expect_hits;
+        self.expect_misses += stats.expect_misses;
     }
 }
 
+/// One context's slice of a specialization's output, for profiling:
+/// how much specialized code a given (PC chain / bucket / named)
+/// context accounts for.
+#[derive(Clone, Debug, Default)]
+pub(crate) struct ContextProfile {
+    /// Human-readable description of the context chain (loop PCs,
+    /// value specializations).
+    pub desc: String,
+    /// Guest-provided name, from `weval_context_name()`, if any.
+    pub name: Option<String>,
+    /// Guest-provided bucket, from `weval_context_bucket()`, if any.
+    pub bucket: Option<u32>,
+    /// Whether the guest marked this context rarely-executed via
+    /// `weval_hint_cold()`.
+    pub cold: bool,
+    /// Reachable specialized blocks attributed to this context.
+    pub blocks: usize,
+    /// Instructions in those blocks.
+    pub insts: usize,
+}
+
+/// Profile of one specialization directive: per-context code-size
+/// attribution and the wall-clock time the directive took to
+/// specialize.
+#[derive(Clone, Debug, Default)]
+pub(crate) struct SpecializationProfile {
+    pub user_id: u32,
+    pub generic: Func,
+    /// Wall-clock time spent specializing this directive, in
+    /// microseconds.
+    pub micros: u128,
+    pub contexts: Vec<ContextProfile>,
+}
+
+/// Write profiles as JSON lines: one object per directive, with a
+/// `contexts` array. Machine-readable so that code-size and
+/// weval-runtime hot spots can be aggregated and diffed by tooling.
+pub(crate) fn write_profiles(
+    path: &Path,
+    profiles: &[SpecializationProfile],
+) -> anyhow::Result<()> {
+    let mut out = std::io::BufWriter::new(std::fs::File::create(path)?);
+    for profile in profiles {
+        write!(
+            &mut out,
+            "{{\"user_id\":{},\"generic\":\"{}\",\"micros\":{},\"contexts\":[",
+            profile.user_id, profile.generic, profile.micros
+        )?;
+        for (i, ctx) in profile.contexts.iter().enumerate() {
+            if i > 0 {
+                write!(&mut out, ",")?;
+            }
+            write!(&mut out, "{{\"desc\":\"{}\",", json_escape(&ctx.desc))?;
+            match &ctx.name {
+                Some(name) => write!(&mut out, "\"name\":\"{}\",", json_escape(name))?,
+                None => write!(&mut out, "\"name\":null,")?,
+            }
+            match ctx.bucket {
+                Some(bucket) => write!(&mut out, "\"bucket\":{bucket},")?,
+                None => write!(&mut out, "\"bucket\":null,")?,
+            }
+            write!(&mut out, "\"cold\":{},", ctx.cold)?;
+            write!(
+                &mut out,
+                "\"blocks\":{},\"insts\":{}}}",
+                ctx.blocks, ctx.insts
+            )?;
+        }
+        writeln!(&mut out, "]}}")?;
+    }
+    Ok(())
+}
+
+fn json_escape(s: &str) -> String {
+    let mut out = String::with_capacity(s.len());
+    for c in s.chars() {
+        match c {
+            '"' => out.push_str("\\\""),
+            '\\' => out.push_str("\\\\"),
+            c if (c as u32) < 0x20 => {
+                out.push_str(&format!("\\u{:04x}", c as u32));
+            }
+            c => out.push(c),
+        }
+    }
+    out
+}
+
 pub(crate) fn count_reachable_blocks_and_insts(
     body: &FunctionBody,
 ) -> (usize, usize, FxHashSet<Block>) {
@@ -67,6 +67,13 @@ pub(crate) enum AbstractValue {
     /// A value only computed at runtime. The instruction that
     /// computed it is specified, if known.
     Runtime(Option<waffle::Value>),
+    /// A value only computed at runtime, but assumed (via
+    /// `weval_assume_range()`) to lie in the given inclusive range.
+    Range(u64, u64),
+    /// A pointer to the given byte offset within a frame declared
+    /// private to the specialized function via
+    /// `weval_promote_frame()`.
+    FrameAddr(u32),
 }
 
 /// Memory pointed to by one of the incoming arguments to a
@@ -94,6 +101,12 @@ impl AbstractValue {
             (AbstractValue::Runtime(cause1), _x) | (_x, AbstractValue::Runtime(cause1)) => {
                 AbstractValue::Runtime(*cause1)
             }
+            // The hull of two assumed ranges; endpoints are drawn
+            // from the finite set of `weval_assume_range()` constants
+            // in the program, so this cannot widen indefinitely.
+            (AbstractValue::Range(lo1, hi1), AbstractValue::Range(lo2, hi2)) => {
+                AbstractValue::Range(*lo1.min(lo2), *hi1.max(hi2))
+            }
             (_av1, _av2) => AbstractValue::Runtime(None),
         }
     }
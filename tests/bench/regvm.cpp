@@ -0,0 +1,352 @@
+/* Register-machine interpreter benchmark: a ~22-opcode three-address
+ * VM with 32 64-bit virtual registers, running a generated program of
+ * a few thousand instructions (a multi-way dispatch chain into 64
+ * payload blocks of random ALU sequences over scratch registers). The
+ * program is deterministic, so the generic and specialized
+ * interpreters must compute the same checksum; main() times both and
+ * reports the speedup. */
+
+#include <weval.h>
+#include <wizer.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+
+WIZER_DEFAULT_INIT();
+
+WEVAL_DEFINE_GLOBALS();
+
+enum Opcode {
+    LoadImm,      /* r[a] = imm */
+    Mov,          /* r[a] = r[b] */
+    Add,          /* r[a] = r[b] + r[c] */
+    Sub,
+    Mul,
+    And,
+    Or,
+    Xor,
+    Shl,          /* r[a] = r[b] << (r[c] & 63) */
+    Shr,
+    Eq,           /* r[a] = r[b] == r[c] */
+    Ne,
+    LtU,
+    GtU,
+    AddImm,       /* r[a] = r[b] + imm */
+    XorImm,
+    MulImm,
+    SelZ,         /* r[a] = r[b] == 0 ? r[c] : r[a] */
+    Jmp,          /* pc = imm */
+    JmpIfZero,    /* if r[a] == 0: pc = imm */
+    JmpIfNotZero, /* if r[a] != 0: pc = imm */
+    Halt,         /* return r[a] */
+};
+
+struct Inst {
+    Opcode opcode;
+    uint32_t a;
+    uint32_t b;
+    uint32_t c;
+    uint32_t imm;
+};
+
+#define NUM_REGS 32
+
+struct State {
+    uint64_t regs[NUM_REGS];
+};
+
+/* Returns (steps << 32) | (checksum truncated to 32 bits), or 0 on a
+ * guard failure. */
+template<bool Specialized>
+uint64_t Interpret(const Inst* insts, uint32_t ninsts, State* state) {
+    uint32_t pc = 0;
+    uint32_t steps = 0;
+    uint64_t* regs = state->regs;
+
+    if (Specialized) {
+        weval::push_context(pc);
+    }
+    while (true) {
+        steps++;
+        const Inst* inst = &insts[pc];
+        pc++;
+        if (Specialized) {
+            weval::update_context(pc);
+        }
+        if (inst->a >= NUM_REGS || inst->b >= NUM_REGS || inst->c >= NUM_REGS) {
+            return 0;
+        }
+        switch (inst->opcode) {
+            case LoadImm:
+                regs[inst->a] = inst->imm;
+                break;
+            case Mov:
+                regs[inst->a] = regs[inst->b];
+                break;
+            case Add:
+                regs[inst->a] = regs[inst->b] + regs[inst->c];
+                break;
+            case Sub:
+                regs[inst->a] = regs[inst->b] - regs[inst->c];
+                break;
+            case Mul:
+                regs[inst->a] = regs[inst->b] * regs[inst->c];
+                break;
+            case And:
+                regs[inst->a] = regs[inst->b] & regs[inst->c];
+                break;
+            case Or:
+                regs[inst->a] = regs[inst->b] | regs[inst->c];
+                break;
+            case Xor:
+                regs[inst->a] = regs[inst->b] ^ regs[inst->c];
+                break;
+            case Shl:
+                regs[inst->a] = regs[inst->b] << (regs[inst->c] & 63);
+                break;
+            case Shr:
+                regs[inst->a] = regs[inst->b] >> (regs[inst->c] & 63);
+                break;
+            case Eq:
+                regs[inst->a] = regs[inst->b] == regs[inst->c];
+                break;
+            case Ne:
+                regs[inst->a] = regs[inst->b] != regs[inst->c];
+                break;
+            case LtU:
+                regs[inst->a] = regs[inst->b] < regs[inst->c];
+                break;
+            case GtU:
+                regs[inst->a] = regs[inst->b] > regs[inst->c];
+                break;
+            case AddImm:
+                regs[inst->a] = regs[inst->b] + inst->imm;
+                break;
+            case XorImm:
+                regs[inst->a] = regs[inst->b] ^ inst->imm;
+                break;
+            case MulImm:
+                regs[inst->a] = regs[inst->b] * inst->imm;
+                break;
+            case SelZ:
+                if (regs[inst->b] == 0) {
+                    regs[inst->a] = regs[inst->c];
+                }
+                break;
+            case Jmp:
+                if (inst->imm >= ninsts) {
+                    return 0;
+                }
+                pc = inst->imm;
+                if (Specialized) {
+                    weval::update_context(pc);
+                }
+                break;
+            case JmpIfZero:
+                if (inst->imm >= ninsts) {
+                    return 0;
+                }
+                if (regs[inst->a] == 0) {
+                    pc = inst->imm;
+                    if (Specialized) {
+                        weval::update_context(pc);
+                    }
+                }
+                break;
+            case JmpIfNotZero:
+                if (inst->imm >= ninsts) {
+                    return 0;
+                }
+                if (regs[inst->a] != 0) {
+                    pc = inst->imm;
+                    if (Specialized) {
+                        weval::update_context(pc);
+                    }
+                }
+                break;
+            case Halt: {
+                uint64_t result = regs[inst->a];
+                if (Specialized) {
+                    weval::pop_context();
+                }
+                return ((uint64_t)steps << 32) | (uint32_t)result;
+            }
+        }
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/* Program generator: deterministic xorshift stream, so the program
+ * (and its checksum) is identical in every build and run.
+ *
+ * Registers 0..3 are counter/checksum/selector/temp; 4..31 are
+ * scratch. */
+
+static const uint32_t kIters = 200000;
+static const uint32_t kNumBlocks = 64;
+#define MAX_PROG 8192
+
+static Inst g_prog[MAX_PROG] = {};
+static uint32_t g_nprog = 0;
+
+static uint32_t g_rng = 0xdeadbeef;
+static uint32_t Rnd() {
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 17;
+    g_rng ^= g_rng << 5;
+    return g_rng;
+}
+
+static uint32_t EmitOp(Opcode opcode, uint32_t a, uint32_t b = 0,
+                       uint32_t c = 0, uint32_t imm = 0) {
+    assert(g_nprog < MAX_PROG);
+    g_prog[g_nprog] = Inst{opcode, a, b, c, imm};
+    return g_nprog++;
+}
+
+static uint32_t ScratchReg() {
+    return 4 + Rnd() % 28;
+}
+
+/* One payload block: a random ALU sequence over scratch registers,
+ * folded into the checksum register, then back to the dispatcher. */
+static void EmitBlock(uint32_t dispatch) {
+    static const Opcode alu3[] = {Add, Sub, Mul, And, Or,  Xor,
+                                  Shl, Shr, Eq,  Ne,  LtU, GtU};
+    uint32_t nops = 8 + Rnd() % 12;
+    for (uint32_t i = 0; i < nops; i++) {
+        switch (Rnd() % 6) {
+            case 0:
+                EmitOp(LoadImm, ScratchReg(), 0, 0, Rnd());
+                break;
+            case 1:
+                EmitOp(AddImm, ScratchReg(), ScratchReg(), 0, Rnd());
+                break;
+            case 2:
+                EmitOp(XorImm, ScratchReg(), ScratchReg(), 0, Rnd());
+                break;
+            case 3:
+                EmitOp(MulImm, ScratchReg(), ScratchReg(), 0, Rnd() | 1);
+                break;
+            case 4:
+                EmitOp(SelZ, ScratchReg(), ScratchReg(), ScratchReg());
+                break;
+            default:
+                EmitOp(alu3[Rnd() % (sizeof(alu3) / sizeof(alu3[0]))],
+                       ScratchReg(), ScratchReg(), ScratchReg());
+                break;
+        }
+    }
+    EmitOp(Xor, 1, 1, ScratchReg());
+    EmitOp(Jmp, 0, 0, 0, dispatch);
+}
+
+static void BuildProgram() {
+    EmitOp(LoadImm, 0, 0, 0, kIters);
+    EmitOp(LoadImm, 1, 0, 0, 0x9e3779b9);
+    for (uint32_t r = 4; r < NUM_REGS; r++) {
+        EmitOp(LoadImm, r, 0, 0, Rnd());
+    }
+
+    /* Dispatcher: exit when the counter hits zero; otherwise
+     * decrement it and branch on its low bits through a compare
+     * chain to one of the payload blocks. */
+    uint32_t dispatch = g_nprog;
+    uint32_t jmp_exit = EmitOp(JmpIfZero, 0, 0, 0, 0);
+    EmitOp(LoadImm, 3, 0, 0, 1);
+    EmitOp(Sub, 0, 0, 3);
+    EmitOp(LoadImm, 3, 0, 0, kNumBlocks - 1);
+    EmitOp(And, 2, 0, 3);
+    uint32_t chain[kNumBlocks];
+    for (uint32_t k = 0; k + 1 < kNumBlocks; k++) {
+        EmitOp(LoadImm, 3, 0, 0, k);
+        EmitOp(Ne, 3, 2, 3);
+        chain[k] = EmitOp(JmpIfZero, 3, 0, 0, 0);
+    }
+    chain[kNumBlocks - 1] = EmitOp(Jmp, 0, 0, 0, 0);
+
+    for (uint32_t k = 0; k < kNumBlocks; k++) {
+        g_prog[chain[k]].imm = g_nprog;
+        EmitBlock(dispatch);
+    }
+
+    g_prog[jmp_exit].imm = g_nprog;
+    EmitOp(Halt, 1);
+}
+
+/* ------------------------------------------------------------------ */
+
+typedef uint64_t (*InterpretFunc)(const Inst* insts, uint32_t ninsts, State* state);
+
+WEVAL_DEFINE_TARGET(1, Interpret<true>);
+
+struct Func {
+    const Inst* insts;
+    uint32_t ninsts;
+    InterpretFunc specialized;
+
+    Func(const Inst* insts_, uint32_t ninsts_)
+        : insts(insts_), ninsts(ninsts_), specialized(nullptr) {
+        auto* req = weval::weval(
+                &specialized,
+                &Interpret<true>,
+                1,
+                0,
+                weval::SpecializeMemory<const Inst*>(insts, ninsts * sizeof(Inst)),
+                weval::Specialize(ninsts),
+                weval::Runtime<State*>());
+        assert(req);
+    }
+
+    uint64_t invoke_generic(State* state) {
+        return Interpret<false>(insts, ninsts, state);
+    }
+    uint64_t invoke_specialized(State* state) {
+        assert(specialized);
+        return specialized(insts, ninsts, state);
+    }
+};
+
+struct ProgramBuilder {
+    ProgramBuilder() { BuildProgram(); }
+};
+ProgramBuilder prog_builder;
+Func prog_func(g_prog, g_nprog);
+
+static double NowMs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+}
+
+int main(int argc, char** argv) {
+    State* state = (State*)calloc(sizeof(State), 1);
+
+    double t0 = NowMs();
+    uint64_t generic = prog_func.invoke_generic(state);
+    double generic_ms = NowMs() - t0;
+    uint32_t steps = (uint32_t)(generic >> 32);
+    assert(steps > 0);
+    printf("regvm: %u insts, %u steps, checksum %08x\n", g_nprog, steps,
+           (uint32_t)generic);
+    printf("generic: %.1f ms (%.1f Msteps/s)\n", generic_ms,
+           (double)steps / generic_ms / 1000.0);
+
+    if (prog_func.specialized) {
+        memset(state, 0, sizeof(State));
+        double t1 = NowMs();
+        uint64_t specialized = prog_func.invoke_specialized(state);
+        double specialized_ms = NowMs() - t1;
+        assert(specialized == generic);
+        printf("specialized: %.1f ms (%.1f Msteps/s), speedup %.2fx\n",
+               specialized_ms, (double)steps / specialized_ms / 1000.0,
+               generic_ms / specialized_ms);
+    } else {
+        printf("specialized: (not wevaled)\n");
+    }
+
+    ::free(state);
+    fflush(stdout);
+}
@@ -0,0 +1,465 @@
+/* Stack-machine interpreter benchmark: a ~24-opcode stack VM running
+ * a generated program of a few thousand instructions with irregular
+ * control flow (a multi-way dispatch chain into 64 payload blocks,
+ * each a branchy random arithmetic sequence). The program is
+ * deterministic, so the generic and specialized interpreters must
+ * compute the same checksum; main() times both and reports the
+ * speedup. */
+
+#include <weval.h>
+#include <wizer.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+
+WIZER_DEFAULT_INIT();
+
+WEVAL_DEFINE_GLOBALS();
+
+enum Opcode {
+    Push,
+    Pop,
+    Dup,
+    Swap,
+    Over,
+    GetLocal,
+    SetLocal,
+    Add,
+    Sub,
+    Mul,
+    And,
+    Or,
+    Xor,
+    Shl,
+    Shr,
+    Eq,
+    Ne,
+    LtU,
+    GtU,
+    Jmp,
+    JmpIfZero,
+    JmpIfNotZero,
+    Halt,
+};
+
+struct Inst {
+    Opcode opcode;
+    uint32_t imm;
+
+    Inst() : opcode(Push), imm(0) {}
+    explicit Inst(Opcode opcode_) : opcode(opcode_), imm(0) {}
+    Inst(Opcode opcode_, uint32_t imm_) : opcode(opcode_), imm(imm_) {}
+};
+
+#define OPSTACK_SIZE 64
+#define LOCAL_SIZE 64
+
+struct State {
+    uint32_t opstack[OPSTACK_SIZE];
+    uint32_t locals[LOCAL_SIZE];
+};
+
+/* Returns (steps << 32) | checksum, or 0 on a guard failure. */
+template<bool Specialized>
+uint64_t Interpret(const Inst* insts, uint32_t ninsts, State* state) {
+    uint32_t pc = 0;
+    uint32_t steps = 0;
+    uint32_t* opstack = state->opstack;
+    uint32_t* locals = state->locals;
+    int sp = 0;
+
+    if (Specialized) {
+        weval::push_context(pc);
+    }
+    while (true) {
+        steps++;
+        const Inst* inst = &insts[pc];
+        pc++;
+        if (Specialized) {
+            weval::update_context(pc);
+        }
+        switch (inst->opcode) {
+            case Push:
+                if (sp + 1 > OPSTACK_SIZE) {
+                    return 0;
+                }
+                opstack[sp++] = inst->imm;
+                break;
+            case Pop:
+                if (sp == 0) {
+                    return 0;
+                }
+                sp--;
+                break;
+            case Dup:
+                if (sp == 0 || sp + 1 > OPSTACK_SIZE) {
+                    return 0;
+                }
+                opstack[sp] = opstack[sp - 1];
+                sp++;
+                break;
+            case Swap: {
+                if (sp < 2) {
+                    return 0;
+                }
+                uint32_t tmp = opstack[sp - 1];
+                opstack[sp - 1] = opstack[sp - 2];
+                opstack[sp - 2] = tmp;
+                break;
+            }
+            case Over:
+                if (sp < 2 || sp + 1 > OPSTACK_SIZE) {
+                    return 0;
+                }
+                opstack[sp] = opstack[sp - 2];
+                sp++;
+                break;
+            case GetLocal:
+                if (sp + 1 > OPSTACK_SIZE || inst->imm >= LOCAL_SIZE) {
+                    return 0;
+                }
+                opstack[sp++] = locals[inst->imm];
+                break;
+            case SetLocal:
+                if (sp == 0 || inst->imm >= LOCAL_SIZE) {
+                    return 0;
+                }
+                locals[inst->imm] = opstack[--sp];
+                break;
+            case Add:
+                if (sp < 2) {
+                    return 0;
+                }
+                opstack[sp - 2] += opstack[sp - 1];
+                sp--;
+                break;
+            case Sub:
+                if (sp < 2) {
+                    return 0;
+                }
+                opstack[sp - 2] -= opstack[sp - 1];
+                sp--;
+                break;
+            case Mul:
+                if (sp < 2) {
+                    return 0;
+                }
+                opstack[sp - 2] *= opstack[sp - 1];
+                sp--;
+                break;
+            case And:
+                if (sp < 2) {
+                    return 0;
+                }
+                opstack[sp - 2] &= opstack[sp - 1];
+                sp--;
+                break;
+            case Or:
+                if (sp < 2) {
+                    return 0;
+                }
+                opstack[sp - 2] |= opstack[sp - 1];
+                sp--;
+                break;
+            case Xor:
+                if (sp < 2) {
+                    return 0;
+                }
+                opstack[sp - 2] ^= opstack[sp - 1];
+                sp--;
+                break;
+            case Shl:
+                if (sp < 2) {
+                    return 0;
+                }
+                opstack[sp - 2] <<= opstack[sp - 1] & 31;
+                sp--;
+                break;
+            case Shr:
+                if (sp < 2) {
+                    return 0;
+                }
+                opstack[sp - 2] >>= opstack[sp - 1] & 31;
+                sp--;
+                break;
+            case Eq:
+                if (sp < 2) {
+                    return 0;
+                }
+                opstack[sp - 2] = opstack[sp - 2] == opstack[sp - 1];
+                sp--;
+                break;
+            case Ne:
+                if (sp < 2) {
+                    return 0;
+                }
+                opstack[sp - 2] = opstack[sp - 2] != opstack[sp - 1];
+                sp--;
+                break;
+            case LtU:
+                if (sp < 2) {
+                    return 0;
+                }
+                opstack[sp - 2] = opstack[sp - 2] < opstack[sp - 1];
+                sp--;
+                break;
+            case GtU:
+                if (sp < 2) {
+                    return 0;
+                }
+                opstack[sp - 2] = opstack[sp - 2] > opstack[sp - 1];
+                sp--;
+                break;
+            case Jmp:
+                if (inst->imm >= ninsts) {
+                    return 0;
+                }
+                pc = inst->imm;
+                if (Specialized) {
+                    weval::update_context(pc);
+                }
+                break;
+            case JmpIfZero:
+                if (sp == 0 || inst->imm >= ninsts) {
+                    return 0;
+                }
+                if (opstack[--sp] == 0) {
+                    pc = inst->imm;
+                    if (Specialized) {
+                        weval::update_context(pc);
+                    }
+                }
+                break;
+            case JmpIfNotZero:
+                if (sp == 0 || inst->imm >= ninsts) {
+                    return 0;
+                }
+                if (opstack[--sp] != 0) {
+                    pc = inst->imm;
+                    if (Specialized) {
+                        weval::update_context(pc);
+                    }
+                }
+                break;
+            case Halt: {
+                if (sp == 0) {
+                    return 0;
+                }
+                uint32_t result = opstack[--sp];
+                if (Specialized) {
+                    weval::pop_context();
+                }
+                return ((uint64_t)steps << 32) | result;
+            }
+        }
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/* Program generator: deterministic xorshift stream, so the program
+ * (and its checksum) is identical in every build and run. */
+
+static const uint32_t kIters = 200000;
+static const uint32_t kNumBlocks = 64;
+#define MAX_PROG 8192
+
+static Inst g_prog[MAX_PROG] = {};
+static uint32_t g_nprog = 0;
+
+static uint32_t g_rng = 0x12345678;
+static uint32_t Rnd() {
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 17;
+    g_rng ^= g_rng << 5;
+    return g_rng;
+}
+
+static uint32_t EmitOp(Opcode opcode, uint32_t imm = 0) {
+    assert(g_nprog < MAX_PROG);
+    g_prog[g_nprog] = Inst(opcode, imm);
+    return g_nprog++;
+}
+
+/* Locals 0..2 are counter/checksum/selector; 3..15 are scratch. */
+static uint32_t ScratchLocal() {
+    return 3 + Rnd() % 13;
+}
+
+/* One payload block: combine the checksum with a random balanced
+ * expression over immediates and scratch locals, with an optional
+ * data-dependent diamond, then store it back and return to the
+ * dispatcher. */
+static void EmitBlock(uint32_t dispatch) {
+    int depth = 1;
+    EmitOp(GetLocal, 1);
+    uint32_t nops = 8 + Rnd() % 12;
+    static const Opcode binops[] = {Add, Sub, Mul, And, Or,  Xor,
+                                    Shl, Shr, Eq,  Ne,  LtU, GtU};
+    for (uint32_t i = 0; i < nops; i++) {
+        if (depth >= 3 && Rnd() % 8 == 0) {
+            EmitOp(SetLocal, ScratchLocal());
+            depth--;
+        } else if (depth < 2 || (depth < 6 && Rnd() % 2 == 0)) {
+            switch (Rnd() % 4) {
+                case 0:
+                    EmitOp(Push, Rnd());
+                    break;
+                case 1:
+                    EmitOp(GetLocal, ScratchLocal());
+                    break;
+                case 2:
+                    EmitOp(Dup);
+                    break;
+                case 3:
+                    if (depth >= 2) {
+                        EmitOp(Over);
+                    } else {
+                        EmitOp(Push, Rnd());
+                    }
+                    break;
+            }
+            depth++;
+        } else {
+            if (Rnd() % 8 == 0) {
+                EmitOp(Swap);
+            }
+            EmitOp(binops[Rnd() % (sizeof(binops) / sizeof(binops[0]))]);
+            depth--;
+        }
+    }
+    while (depth > 1) {
+        EmitOp(Xor);
+        depth--;
+    }
+    if (Rnd() % 2 == 0) {
+        EmitOp(Dup);
+        EmitOp(Push, Rnd());
+        EmitOp(GtU);
+        uint32_t br = EmitOp(JmpIfNotZero, 0);
+        EmitOp(Push, Rnd());
+        EmitOp(Add);
+        uint32_t jmp_join = EmitOp(Jmp, 0);
+        g_prog[br].imm = g_nprog;
+        EmitOp(Push, Rnd());
+        EmitOp(Xor);
+        g_prog[jmp_join].imm = g_nprog;
+    }
+    EmitOp(SetLocal, 1);
+    EmitOp(Jmp, dispatch);
+}
+
+static void BuildProgram() {
+    EmitOp(Push, kIters);
+    EmitOp(SetLocal, 0);
+    EmitOp(Push, 0x9e3779b9);
+    EmitOp(SetLocal, 1);
+
+    /* Dispatcher: exit when the counter hits zero; otherwise
+     * decrement it and branch on its low bits through a compare
+     * chain to one of the payload blocks. */
+    uint32_t dispatch = g_nprog;
+    EmitOp(GetLocal, 0);
+    uint32_t jmp_exit = EmitOp(JmpIfZero, 0);
+    EmitOp(GetLocal, 0);
+    EmitOp(Push, 1);
+    EmitOp(Sub);
+    EmitOp(SetLocal, 0);
+    EmitOp(GetLocal, 0);
+    EmitOp(Push, kNumBlocks - 1);
+    EmitOp(And);
+    EmitOp(SetLocal, 2);
+    uint32_t chain[kNumBlocks];
+    for (uint32_t k = 0; k + 1 < kNumBlocks; k++) {
+        EmitOp(GetLocal, 2);
+        EmitOp(Push, k);
+        EmitOp(Eq);
+        chain[k] = EmitOp(JmpIfNotZero, 0);
+    }
+    chain[kNumBlocks - 1] = EmitOp(Jmp, 0);
+
+    for (uint32_t k = 0; k < kNumBlocks; k++) {
+        g_prog[chain[k]].imm = g_nprog;
+        EmitBlock(dispatch);
+    }
+
+    g_prog[jmp_exit].imm = g_nprog;
+    EmitOp(GetLocal, 1);
+    EmitOp(Halt);
+}
+
+/* ------------------------------------------------------------------ */
+
+typedef uint64_t (*InterpretFunc)(const Inst* insts, uint32_t ninsts, State* state);
+
+WEVAL_DEFINE_TARGET(1, Interpret<true>);
+
+struct Func {
+    const Inst* insts;
+    uint32_t ninsts;
+    InterpretFunc specialized;
+
+    Func(const Inst* insts_, uint32_t ninsts_)
+        : insts(insts_), ninsts(ninsts_), specialized(nullptr) {
+        auto* req = weval::weval(
+                &specialized,
+                &Interpret<true>,
+                1,
+                0,
+                weval::SpecializeMemory<const Inst*>(insts, ninsts * sizeof(Inst)),
+                weval::Specialize(ninsts),
+                weval::Runtime<State*>());
+        assert(req);
+    }
+
+    uint64_t invoke_generic(State* state) {
+        return Interpret<false>(insts, ninsts, state);
+    }
+    uint64_t invoke_specialized(State* state) {
+        assert(specialized);
+        return specialized(insts, ninsts, state);
+    }
+};
+
+struct ProgramBuilder {
+    ProgramBuilder() { BuildProgram(); }
+};
+ProgramBuilder prog_builder;
+Func prog_func(g_prog, g_nprog);
+
+static double NowMs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+}
+
+int main(int argc, char** argv) {
+    State* state = (State*)calloc(sizeof(State), 1);
+
+    double t0 = NowMs();
+    uint64_t generic = prog_func.invoke_generic(state);
+    double generic_ms = NowMs() - t0;
+    uint32_t steps = (uint32_t)(generic >> 32);
+    assert(steps > 0);
+    printf("stackvm: %u insts, %u steps, checksum %08x\n", g_nprog,
+           steps, (uint32_t)generic);
+    printf("generic: %.1f ms (%.1f Msteps/s)\n", generic_ms,
+           (double)steps / generic_ms / 1000.0);
+
+    if (prog_func.specialized) {
+        memset(state, 0, sizeof(State));
+        double t1 = NowMs();
+        uint64_t specialized = prog_func.invoke_specialized(state);
+        double specialized_ms = NowMs() - t1;
+        assert(specialized == generic);
+        printf("specialized: %.1f ms (%.1f Msteps/s), speedup %.2fx\n",
+               specialized_ms, (double)steps / specialized_ms / 1000.0,
+               generic_ms / specialized_ms);
+    } else {
+        printf("specialized: (not wevaled)\n");
+    }
+
+    ::free(state);
+    fflush(stdout);
+}
@@ -161,6 +161,187 @@ out:
     return steps;
 }
 
+/* A second interpreter over the same bytecode that routes all
+ * operand-stack traffic through the virtual-stack intrinsics
+ * (weval_push_stack()/weval_pop_stack()/weval_read_stack()) instead of
+ * raw array stores, exercising that subsystem end to end. The
+ * specializer tracks pushed values abstractly and cancels the store
+ * when a pop consumes them, so stack traffic that never reaches a sync
+ * point costs no memory ops in the specialized output; the elision is
+ * reported per function by `--show-stats` (virtstack reads/writes
+ * vs. their `mem` counterparts -- this variant versus the raw-array
+ * `Interpret` above). The virtual-stack API is defined over 8-byte
+ * slots, so this variant carries its own state layout. */
+
+struct VirtState {
+    uint64_t opstack[OPSTACK_SIZE];
+    uint64_t locals[LOCAL_SIZE];
+};
+
+template<bool Specialized>
+uint32_t InterpretVirt(const Inst* insts, uint32_t ninsts, VirtState* state) {
+    uint32_t pc = 0;
+    uint32_t steps = 0;
+    uint64_t* opstack = state->opstack;
+    uint64_t* locals = state->locals;
+    int sp = 0;
+
+    if (Specialized) {
+        weval::push_context(pc);
+    }
+    while (true) {
+        steps++;
+        const Inst* inst = &insts[pc];
+        pc++;
+        if (Specialized) {
+            weval::update_context(pc);
+        }
+        switch (inst->opcode) {
+            case PushConst:
+                if (sp + 1 > OPSTACK_SIZE) {
+                    return 0;
+                }
+                if (Specialized) {
+                    weval_push_stack(&opstack[sp], inst->imm);
+                } else {
+                    opstack[sp] = inst->imm;
+                }
+                sp++;
+                break;
+            case Drop:
+                if (sp == 0) {
+                    return 0;
+                }
+                sp--;
+                if (Specialized) {
+                    (void)weval_pop_stack(&opstack[sp]);
+                }
+                break;
+            case Dup:
+                if (sp + 1 > OPSTACK_SIZE) {
+                    return 0;
+                }
+                if (sp == 0) {
+                    return 0;
+                }
+                if (Specialized) {
+                    weval_push_stack(&opstack[sp],
+                                     weval_read_stack(&opstack[sp - 1], 0));
+                } else {
+                    opstack[sp] = opstack[sp - 1];
+                }
+                sp++;
+                break;
+            case GetLocal:
+                if (sp + 1 > OPSTACK_SIZE) {
+                    return 0;
+                }
+                if (inst->imm >= LOCAL_SIZE) {
+                    return 0;
+                }
+                if (Specialized) {
+                    weval_push_stack(&opstack[sp], locals[inst->imm]);
+                } else {
+                    opstack[sp] = locals[inst->imm];
+                }
+                sp++;
+                break;
+            case SetLocal:
+                if (sp == 0) {
+                    return 0;
+                }
+                if (inst->imm >= LOCAL_SIZE) {
+                    return 0;
+                }
+                sp--;
+                if (Specialized) {
+                    locals[inst->imm] = weval_pop_stack(&opstack[sp]);
+                } else {
+                    locals[inst->imm] = opstack[sp];
+                }
+                break;
+            case Add:
+                if (sp < 2) {
+                    return 0;
+                }
+                if (Specialized) {
+                    uint64_t b = weval_pop_stack(&opstack[sp - 1]);
+                    uint64_t a = weval_pop_stack(&opstack[sp - 2]);
+                    weval_push_stack(&opstack[sp - 2], a + b);
+                } else {
+                    opstack[sp - 2] += opstack[sp - 1];
+                }
+                sp--;
+                break;
+            case Sub:
+                if (sp < 2) {
+                    return 0;
+                }
+                if (Specialized) {
+                    uint64_t b = weval_pop_stack(&opstack[sp - 1]);
+                    uint64_t a = weval_pop_stack(&opstack[sp - 2]);
+                    weval_push_stack(&opstack[sp - 2], a - b);
+                } else {
+                    opstack[sp - 2] -= opstack[sp - 1];
+                }
+                sp--;
+                break;
+            case Print:
+                if (sp == 0) {
+                    return 0;
+                }
+                sp--;
+                if (Specialized) {
+                    printf("%u\n", (uint32_t)weval_pop_stack(&opstack[sp]));
+                } else {
+                    printf("%u\n", (uint32_t)opstack[sp]);
+                }
+                break;
+            case Goto:
+                if (inst->imm >= ninsts) {
+                    return 0;
+                }
+                pc = inst->imm;
+                if (Specialized) {
+                    weval::update_context(pc);
+                }
+                break;
+            case GotoIf: {
+                if (sp == 0) {
+                    return 0;
+                }
+                if (inst->imm >= ninsts) {
+                    return 0;
+                }
+                sp--;
+                uint64_t cond;
+                if (Specialized) {
+                    cond = weval_pop_stack(&opstack[sp]);
+                } else {
+                    cond = opstack[sp];
+                }
+                if (cond != 0) {
+                    pc = inst->imm;
+                    if (Specialized) {
+                        weval::update_context(pc);
+                    }
+                    continue;
+                }
+                break;
+            }
+            case Exit:
+                goto out;
+        }
+    }
+out:
+    if (Specialized) {
+        weval::pop_context();
+    }
+
+    printf("Exiting after %d steps at PC %d.\n", steps, pc);
+    return steps;
+}
+
 static const uint32_t kIters = 10000000;
 Inst prog[] = {
     Inst(PushConst, 0),
@@ -176,8 +357,10 @@ Inst prog[] = {
 static const uint32_t kExpectedSteps = 7*kIters + 6;
 
 typedef uint32_t (*InterpretFunc)(const Inst* insts, uint32_t ninsts, State* state);
+typedef uint32_t (*InterpretVirtFunc)(const Inst* insts, uint32_t ninsts, VirtState* state);
 
 WEVAL_DEFINE_TARGET(1, Interpret<true>);
+WEVAL_DEFINE_TARGET(2, InterpretVirt<true>);
 
 struct Func {
     const Inst* insts;
@@ -208,24 +391,58 @@ struct Func {
     }
 };
 
+struct FuncVirt {
+    const Inst* insts;
+    uint32_t ninsts;
+    InterpretVirtFunc specialized;
+
+    FuncVirt(const Inst* insts_, uint32_t ninsts_)
+        : insts(insts_), ninsts(ninsts_), specialized(nullptr) {
+        auto* req = weval::weval(
+                &specialized,
+                &InterpretVirt<true>,
+                2,
+                0,
+                weval::SpecializeMemory<const Inst*>(insts, ninsts * sizeof(Inst)),
+                weval::Specialize(ninsts),
+                weval::Runtime<VirtState*>());
+        assert(req);
+    }
+
+    uint32_t invoke(VirtState* state) {
+        if (specialized) {
+            printf("Calling specialized virtual-stack function: %p\n", specialized);
+            return specialized(insts, ninsts, state);
+        }
+        return InterpretVirt<false>(insts, ninsts, state);
+    }
+};
+
 #ifndef WEVAL_COMPONENT_TEST
 Func prog_func(prog, sizeof(prog)/sizeof(Inst));
+FuncVirt prog_func_virt(prog, sizeof(prog)/sizeof(Inst));
 
 int main(int argc, char** argv) {
     State* state = (State*)calloc(sizeof(State), 1);
     uint32_t steps = prog_func.invoke(state);
     assert(kExpectedSteps == steps);
+    VirtState* vstate = (VirtState*)calloc(sizeof(VirtState), 1);
+    uint32_t vsteps = prog_func_virt.invoke(vstate);
+    assert(kExpectedSteps == vsteps);
     fflush(stdout);
 }
 
 #else
 static Func* prog_func = nullptr;
+static FuncVirt* prog_func_virt = nullptr;
 
 namespace exports::component {
 
 void Initialize() {
     prog_func = new Func(prog, sizeof(prog)/sizeof(Inst));
     assert(prog_func);
+    prog_func_virt = new FuncVirt(prog, sizeof(prog)/sizeof(Inst));
+    assert(prog_func_virt);
 }
 
 int32_t Run() {
@@ -235,6 +452,12 @@ int32_t Run() {
     ::free(state);
     assert(weval_is_wevaled);
     assert(steps == kExpectedSteps);
+
+    assert(prog_func_virt);
+    VirtState* vstate = (VirtState*)calloc(sizeof(VirtState), 1);
+    uint32_t vsteps = prog_func_virt->invoke(vstate);
+    ::free(vstate);
+    assert(vsteps == kExpectedSteps);
     return 0;
 }
 